@@ -0,0 +1,138 @@
+//! Inputs shared by the benchmarks: the bundled assets, the Draco primitives of
+//! `assets/20/20.gltf` and synthetic grids from 10K to 10M vertices.
+//!
+//! The grids are encoded with Draco's `draco_encoder` tool (taken from
+//! `DRACO_ENCODER` or the Draco build directory) and cached in
+//! `target/bench-assets`; they are skipped if the tool is missing. Set
+//! `DRACO_BENCH_MAX_VERTICES` to limit the largest grid.
+
+// Every benchmark uses a part of this module.
+#![allow(dead_code)]
+
+use std::fs;
+use std::io::{BufWriter, Write};
+use std::path::{Path, PathBuf};
+use std::process::Command;
+
+use draco_decoder::DracoFile;
+
+const SYNTHETIC_VERTEX_COUNTS: [usize; 4] = [10_000, 100_000, 1_000_000, 10_000_000];
+
+pub struct Input {
+    pub name: String,
+    pub data: Vec<u8>,
+}
+
+/// Meshes to benchmark: the bundled assets, the glTF primitives and the
+/// synthetic grids.
+pub fn mesh_inputs() -> Vec<Input> {
+    let mut inputs = vec![Input {
+        name: "mesh.drc".to_string(),
+        data: fs::read("assets/mesh.drc").expect("Failed to read mesh.drc"),
+    }];
+    inputs.extend(gltf_primitives(Path::new("assets/20/20.gltf")));
+    inputs.extend(synthetic_meshes());
+    inputs
+}
+
+/// Returns the Draco blob of every primitive of a glTF or GLB file, as listed
+/// by [`DracoFile::primitives`].
+pub fn gltf_primitives(path: &Path) -> Vec<Input> {
+    let file = DracoFile::open(path).expect("Failed to open glTF file");
+    let name = path.file_name().unwrap().to_string_lossy();
+    file.primitives()
+        .iter()
+        .map(|primitive| Input {
+            name: format!(
+                "{name}/mesh{}/primitive{}",
+                primitive.mesh_index(),
+                primitive.primitive_index()
+            ),
+            data: file.data(primitive).to_vec(),
+        })
+        .collect()
+}
+
+fn draco_encoder() -> Option<PathBuf> {
+    if let Some(path) = std::env::var_os("DRACO_ENCODER") {
+        return Some(PathBuf::from(path));
+    }
+    [
+        "third_party/draco/build/draco_encoder",
+        "third_party/draco/build/install/bin/draco_encoder",
+        "third_party/draco/build/Release/draco_encoder.exe",
+    ]
+    .into_iter()
+    .map(PathBuf::from)
+    .find(|path| path.exists())
+}
+
+/// Encodes a square grid of at least `vertex_count` vertices with normals and
+/// texture coordinates, caching the result.
+fn synthetic_mesh(encoder: &Path, vertex_count: usize) -> Option<Vec<u8>> {
+    let dir = Path::new("target/bench-assets");
+    let drc = dir.join(format!("grid_{vertex_count}.drc"));
+    if let Ok(data) = fs::read(&drc) {
+        return Some(data);
+    }
+
+    fs::create_dir_all(dir).ok()?;
+    let obj = dir.join(format!("grid_{vertex_count}.obj"));
+    let side = (vertex_count as f64).sqrt().ceil() as usize;
+    let mut out = BufWriter::new(fs::File::create(&obj).ok()?);
+    for y in 0..side {
+        for x in 0..side {
+            let (u, v) = (x as f32 / side as f32, y as f32 / side as f32);
+            let z = (u * 20.0).sin() * (v * 20.0).cos() * 0.05;
+            writeln!(out, "v {u} {v} {z}").ok()?;
+            writeln!(out, "vt {u} {v}").ok()?;
+            writeln!(out, "vn 0 0 1").ok()?;
+        }
+    }
+    for y in 0..side - 1 {
+        for x in 0..side - 1 {
+            let a = y * side + x + 1;
+            let (b, c, d) = (a + 1, a + side, a + side + 1);
+            writeln!(out, "f {a}/{a}/{a} {b}/{b}/{b} {d}/{d}/{d}").ok()?;
+            writeln!(out, "f {a}/{a}/{a} {d}/{d}/{d} {c}/{c}/{c}").ok()?;
+        }
+    }
+    out.flush().ok()?;
+    drop(out);
+
+    let status = Command::new(encoder)
+        .arg("-i")
+        .arg(&obj)
+        .arg("-o")
+        .arg(&drc)
+        .status()
+        .ok()?;
+    fs::remove_file(&obj).ok();
+    if !status.success() {
+        return None;
+    }
+    fs::read(&drc).ok()
+}
+
+pub fn synthetic_meshes() -> Vec<Input> {
+    let Some(encoder) = draco_encoder() else {
+        eprintln!("draco_encoder not found, skipping synthetic meshes");
+        return Vec::new();
+    };
+    let max_vertices = std::env::var("DRACO_BENCH_MAX_VERTICES")
+        .ok()
+        .and_then(|value| value.parse().ok())
+        .unwrap_or(usize::MAX);
+
+    SYNTHETIC_VERTEX_COUNTS
+        .into_iter()
+        .filter(|&count| count <= max_vertices)
+        .filter_map(|count| {
+            let data = synthetic_mesh(&encoder, count)?;
+            Some(Input {
+                name: format!("grid_{count}"),
+                data,
+            })
+        })
+        .collect()
+}
@@ -0,0 +1,98 @@
+//! Decode throughput benchmarks.
+//!
+//! Run with `cargo bench --bench decode`. Every stage is measured on its own
+//! and reported both in MB/s and in vertices/s:
+//!
+//! - `create_mesh` - Draco decode of the compressed blob, plus the config
+//! - `compute_mesh_config` - layout computation of an already decoded mesh
+//! - `decode_mesh_to_buffer` - writing the decoded mesh into a buffer
+//! - `decode_point_cloud` - Draco decode and write of a point cloud
+//!
+//! Inputs are the bundled assets, the Draco primitives of `assets/20/20.gltf`
+//! and synthetic grids from 10K to 10M vertices, see [`common`].
+
+mod common;
+
+use std::fs;
+
+use criterion::{BenchmarkId, Criterion, Throughput, criterion_group, criterion_main};
+use draco_decoder::{DecodeOptions, DracoMesh, DracoPointCloud};
+
+use common::{Input, mesh_inputs};
+
+/// Reports MB/s of `bytes` and vertices/s of `vertices`.
+fn throughput(bytes: usize, vertices: u32) -> Throughput {
+    Throughput::ElementsAndBytes {
+        elements: u64::from(vertices),
+        bytes: bytes as u64,
+    }
+}
+
+fn bench_meshes(c: &mut Criterion) {
+    let inputs = mesh_inputs();
+    let mut meshes: Vec<(&Input, DracoMesh)> = inputs
+        .iter()
+        .map(|input| {
+            let mesh = DracoMesh::new(&input.data).expect("Failed to decode mesh");
+            (input, mesh)
+        })
+        .collect();
+
+    // Compressed bytes in, decoded vertices out.
+    let mut group = c.benchmark_group("create_mesh");
+    for (input, mesh) in &meshes {
+        group.throughput(throughput(input.data.len(), mesh.config().vertex_count()));
+        group.bench_with_input(
+            BenchmarkId::from_parameter(&input.name),
+            input,
+            |b, input| b.iter(|| DracoMesh::new(&input.data).unwrap()),
+        );
+    }
+    group.finish();
+
+    let mut group = c.benchmark_group("compute_mesh_config");
+    let options = DecodeOptions::new();
+    for (input, mesh) in &mut meshes {
+        group.throughput(throughput(
+            mesh.config().buffer_size(),
+            mesh.config().vertex_count(),
+        ));
+        group.bench_function(BenchmarkId::from_parameter(&input.name), |b| {
+            b.iter(|| assert!(mesh.set_options(&options)))
+        });
+    }
+    group.finish();
+
+    // Decoded bytes written.
+    let mut group = c.benchmark_group("decode_mesh_to_buffer");
+    for (input, mesh) in &meshes {
+        let size = mesh.config().buffer_size();
+        let mut out = vec![0u8; size];
+        group.throughput(throughput(size, mesh.config().vertex_count()));
+        group.bench_function(BenchmarkId::from_parameter(&input.name), |b| {
+            b.iter(|| mesh.decode_into(&mut out).unwrap())
+        });
+    }
+    group.finish();
+}
+
+fn bench_point_clouds(c: &mut Criterion) {
+    let data = fs::read("assets/pointcloud.drc").expect("Failed to read pointcloud.drc");
+    let num_points = DracoPointCloud::new(&data)
+        .expect("Failed to decode point cloud")
+        .num_points();
+
+    let mut group = c.benchmark_group("decode_point_cloud");
+    group.throughput(throughput(data.len(), num_points));
+    group.bench_function("pointcloud.drc", |b| {
+        let mut out = Vec::new();
+        b.iter(|| {
+            let cloud = DracoPointCloud::new(&data).unwrap();
+            cloud.decode_points_into(0, num_points, &mut out).unwrap()
+        })
+    });
+    group.finish();
+}
+
+criterion_group!(benches, bench_meshes, bench_point_clouds);
+criterion_main!(benches);
@@ -0,0 +1,306 @@
+//! Multi-threaded scaling benchmark.
+//!
+//! Run with `cargo bench --bench scaling`. Every workload is decoded on 1, 2,
+//! 4, ... up to N threads at once, each thread decoding back to back for a
+//! fixed time, and for every thread count the report lists:
+//!
+//! - decodes/s and MB/s of decoded output, and the speedup over one thread
+//! - p50 and p99 latency of a single decode
+//! - Rust heap allocations per decode (the output buffer and the `rust::Vec`s
+//!   grown by C++), plus the C++ ones when built with `--features perf`
+//!
+//! A speedup that flattens while the allocations per decode stay the same
+//! points at contention rather than extra work.
+//!
+//! The workloads are `decode_mesh_with_config_sync` over `assets/mesh.drc`,
+//! over every Draco primitive of `assets/20/20.gltf` in turn and over the
+//! synthetic grids of [`common`], and `decode_point_cloud_with_config_sync`
+//! over `assets/pointcloud.drc`. `DRACO_BENCH_MAX_THREADS` sets N (default:
+//! the available parallelism) and `DRACO_BENCH_SECONDS` the time per thread
+//! count (default: 2).
+
+mod common;
+
+use std::alloc::{GlobalAlloc, Layout, System};
+use std::cell::Cell;
+use std::fs;
+use std::path::Path;
+use std::sync::Barrier;
+use std::thread;
+use std::time::{Duration, Instant};
+
+use draco_decoder::{decode_mesh_with_config_sync, decode_point_cloud_with_config_sync};
+
+use common::{Input, gltf_primitives, synthetic_meshes};
+
+/// Counts the heap allocations of every thread, including those made by C++
+/// through `rust::Vec`.
+struct CountingAllocator;
+
+thread_local! {
+    // Per thread, so counting adds no contention of its own.
+    static ALLOCATIONS: Cell<u64> = const { Cell::new(0) };
+}
+
+fn count_allocation() {
+    let _ = ALLOCATIONS.try_with(|count| count.set(count.get() + 1));
+}
+
+fn allocations() -> u64 {
+    ALLOCATIONS.try_with(Cell::get).unwrap_or(0)
+}
+
+unsafe impl GlobalAlloc for CountingAllocator {
+    unsafe fn alloc(&self, layout: Layout) -> *mut u8 {
+        count_allocation();
+        unsafe { System.alloc(layout) }
+    }
+
+    unsafe fn alloc_zeroed(&self, layout: Layout) -> *mut u8 {
+        count_allocation();
+        unsafe { System.alloc_zeroed(layout) }
+    }
+
+    unsafe fn realloc(&self, ptr: *mut u8, layout: Layout, new_size: usize) -> *mut u8 {
+        count_allocation();
+        unsafe { System.realloc(ptr, layout, new_size) }
+    }
+
+    unsafe fn dealloc(&self, ptr: *mut u8, layout: Layout) {
+        unsafe { System.dealloc(ptr, layout) }
+    }
+}
+
+#[global_allocator]
+static GLOBAL: CountingAllocator = CountingAllocator;
+
+#[derive(Clone, Copy, PartialEq, Eq)]
+enum Kind {
+    Mesh,
+    PointCloud,
+}
+
+/// Blobs decoded in turn by every thread.
+struct Workload {
+    name: String,
+    kind: Kind,
+    blobs: Vec<Vec<u8>>,
+}
+
+impl Workload {
+    fn new(name: &str, kind: Kind, inputs: Vec<Input>) -> Self {
+        Self {
+            name: name.to_string(),
+            kind,
+            blobs: inputs.into_iter().map(|input| input.data).collect(),
+        }
+    }
+
+    /// Decodes `blob` and returns the size of the decoded buffer.
+    fn decode(&self, blob: &[u8]) -> usize {
+        match self.kind {
+            Kind::Mesh => decode_mesh_with_config_sync(blob),
+            Kind::PointCloud => decode_point_cloud_with_config_sync(blob),
+        }
+        .expect("Decode failed")
+        .data
+        .len()
+    }
+
+    /// C++ heap allocations of one decode, averaged over the blobs.
+    #[cfg(feature = "perf")]
+    fn cpp_allocations(&self) -> Option<f64> {
+        if self.kind != Kind::Mesh {
+            return None;
+        }
+        let total: u64 = self
+            .blobs
+            .iter()
+            .map(|blob| {
+                let (_, stats) =
+                    draco_decoder::decode_mesh_with_stats_sync(blob).expect("Decode failed");
+                stats.allocations
+            })
+            .sum();
+        Some(total as f64 / self.blobs.len() as f64)
+    }
+
+    #[cfg(not(feature = "perf"))]
+    fn cpp_allocations(&self) -> Option<f64> {
+        None
+    }
+}
+
+fn workloads() -> Vec<Workload> {
+    let read = |path: &str| Input {
+        name: path.to_string(),
+        data: fs::read(path).unwrap_or_else(|_| panic!("Failed to read {path}")),
+    };
+    let mut workloads = vec![
+        Workload::new("mesh.drc", Kind::Mesh, vec![read("assets/mesh.drc")]),
+        Workload::new(
+            "20.gltf",
+            Kind::Mesh,
+            gltf_primitives(Path::new("assets/20/20.gltf")),
+        ),
+    ];
+    for input in synthetic_meshes() {
+        let name = input.name.clone();
+        workloads.push(Workload::new(&name, Kind::Mesh, vec![input]));
+    }
+    workloads.push(Workload::new(
+        "pointcloud.drc",
+        Kind::PointCloud,
+        vec![read("assets/pointcloud.drc")],
+    ));
+    workloads
+}
+
+/// Result of running a workload on a number of threads.
+struct Step {
+    threads: usize,
+    elapsed: Duration,
+    bytes: usize,
+    allocations: u64,
+    latencies: Vec<Duration>,
+}
+
+impl Step {
+    fn decodes_per_sec(&self) -> f64 {
+        self.latencies.len() as f64 / self.elapsed.as_secs_f64()
+    }
+
+    fn percentile_ms(&self, q: f64) -> f64 {
+        let index = ((self.latencies.len() - 1) as f64 * q).round() as usize;
+        self.latencies[index].as_secs_f64() * 1e3
+    }
+}
+
+/// Decodes `workload` on `threads` threads at once for `duration`. Every
+/// thread starts at a different blob so they do not run in lockstep.
+fn run(workload: &Workload, threads: usize, duration: Duration) -> Step {
+    let barrier = Barrier::new(threads + 1);
+    let (elapsed, samples) = thread::scope(|scope| {
+        let workers: Vec<_> = (0..threads)
+            .map(|t| {
+                let barrier = &barrier;
+                scope.spawn(move || {
+                    let mut latencies = Vec::with_capacity(1 << 16);
+                    let mut bytes = 0;
+                    let mut allocations_total = 0;
+                    barrier.wait();
+                    let deadline = Instant::now() + duration;
+                    for blob in workload.blobs.iter().cycle().skip(t) {
+                        let before = allocations();
+                        let start = Instant::now();
+                        bytes += workload.decode(blob);
+                        let end = Instant::now();
+                        allocations_total += allocations() - before;
+                        latencies.push(end - start);
+                        if end >= deadline {
+                            break;
+                        }
+                    }
+                    (latencies, bytes, allocations_total)
+                })
+            })
+            .collect();
+        barrier.wait();
+        let start = Instant::now();
+        let samples: Vec<_> = workers
+            .into_iter()
+            .map(|worker| worker.join().expect("Worker panicked"))
+            .collect();
+        (start.elapsed(), samples)
+    });
+
+    let mut step = Step {
+        threads,
+        elapsed,
+        bytes: 0,
+        allocations: 0,
+        latencies: Vec::new(),
+    };
+    for (latencies, bytes, allocations) in samples {
+        step.latencies.extend(latencies);
+        step.bytes += bytes;
+        step.allocations += allocations;
+    }
+    step.latencies.sort_unstable();
+    step
+}
+
+fn env_or<T: std::str::FromStr>(name: &str, default: T) -> T {
+    std::env::var(name)
+        .ok()
+        .and_then(|value| value.parse().ok())
+        .unwrap_or(default)
+}
+
+/// 1, 2, 4, ... below `max`, then `max` itself.
+fn thread_counts(max: usize) -> Vec<usize> {
+    let mut counts: Vec<usize> = (0..)
+        .map(|shift| 1 << shift)
+        .take_while(|&count| count < max)
+        .collect();
+    counts.push(max);
+    counts
+}
+
+fn main() {
+    // `cargo bench` passes `--bench`; a filter argument selects workloads.
+    let filter = std::env::args().skip(1).find(|arg| !arg.starts_with('-'));
+    let parallelism = thread::available_parallelism().map_or(1, |n| n.get());
+    let max_threads = env_or("DRACO_BENCH_MAX_THREADS", parallelism).max(1);
+    let duration = Duration::from_secs_f64(env_or("DRACO_BENCH_SECONDS", 2.0));
+
+    for workload in workloads() {
+        if filter
+            .as_ref()
+            .is_some_and(|filter| !workload.name.contains(filter.as_str()))
+        {
+            continue;
+        }
+        let compressed: usize = workload.blobs.iter().map(Vec::len).sum();
+        println!(
+            "\n{} ({} blob(s), {:.2} MB compressed)",
+            workload.name,
+            workload.blobs.len(),
+            compressed as f64 / 1e6
+        );
+        let cpp_allocations = workload.cpp_allocations();
+        println!(
+            "{:>7} {:>11} {:>9} {:>8} {:>9} {:>9} {:>12} {:>12}",
+            "threads",
+            "decodes/s",
+            "MB/s",
+            "speedup",
+            "p50 ms",
+            "p99 ms",
+            "rust allocs",
+            "c++ allocs"
+        );
+
+        // Warm up the allocator and the caches.
+        for blob in &workload.blobs {
+            workload.decode(blob);
+        }
+        let mut baseline = None;
+        for threads in thread_counts(max_threads) {
+            let step = run(&workload, threads, duration);
+            let rate = step.decodes_per_sec();
+            let baseline = *baseline.get_or_insert(rate);
+            println!(
+                "{:>7} {:>11.1} {:>9.1} {:>7.2}x {:>9.3} {:>9.3} {:>12.1} {:>12}",
+                step.threads,
+                rate,
+                step.bytes as f64 / 1e6 / step.elapsed.as_secs_f64(),
+                rate / baseline,
+                step.percentile_ms(0.5),
+                step.percentile_ms(0.99),
+                step.allocations as f64 / step.latencies.len() as f64,
+                cpp_allocations.map_or("-".to_string(), |count| format!("{count:.1}")),
+            );
+        }
+    }
+}
@@ -35,34 +35,98 @@ fn main() {
         std::fs::create_dir_all(&draco_build).unwrap();
     }
 
+    let msvc = target.contains("windows-msvc");
+    let decoder_only = feature("DECODER_ONLY");
+    let target_cpu = target_cpu();
+    let thin_lto = feature("THIN_LTO") && thin_lto_supported(&target);
+
+    // Flags for both the Draco build and decoder_api, so inlined Draco code
+    // is compiled the same way on both sides.
+    let mut cxx_flags = Vec::new();
+    if let Some(cpu) = &target_cpu {
+        if !msvc {
+            cxx_flags.push(format!("-march={cpu}"));
+        } else if cpu != "native" {
+            cxx_flags.push(format!("/arch:{cpu}"));
+        } else {
+            println!("cargo:warning=MSVC has no -march=native, ignoring native-cpu");
+        }
+    }
+
+    // Setting CMAKE_CXX_FLAGS replaces CMake's defaults, which are only
+    // empty for GCC and Clang.
+    let mut draco_flags: Vec<String> = if msvc {
+        ["/DWIN32", "/D_WINDOWS", "/W3", "/GR", "/EHsc"]
+            .map(String::from)
+            .to_vec()
+    } else {
+        Vec::new()
+    };
+    draco_flags.extend(cxx_flags.iter().cloned());
+    if decoder_only {
+        // Lets the linker drop the encoder, which libdraco always contains.
+        if msvc {
+            draco_flags.extend(["/Gy".to_string(), "/Gw".to_string()]);
+        } else {
+            draco_flags.extend([
+                "-ffunction-sections".to_string(),
+                "-fdata-sections".to_string(),
+            ]);
+        }
+    }
+
+    let mut configure_args = vec![
+        "..".to_string(),
+        "-DBUILD_SHARED_LIBS=OFF".to_string(),
+        "-DCMAKE_BUILD_TYPE=Release".to_string(),
+        "-DDRACO_TESTS=OFF".to_string(),
+        format!("-DCMAKE_INSTALL_PREFIX={}", "install"),
+        format!("-DCMAKE_CXX_FLAGS={}", draco_flags.join(" ")),
+        // Clang's IPO is ThinLTO, archived with llvm-ar.
+        format!(
+            "-DCMAKE_INTERPROCEDURAL_OPTIMIZATION={}",
+            if thin_lto { "ON" } else { "OFF" }
+        ),
+    ];
+    if thin_lto {
+        let compiler = cc::Build::new().cpp(true).get_compiler();
+        configure_args.push(format!(
+            "-DCMAKE_CXX_COMPILER={}",
+            compiler.path().display()
+        ));
+    }
+
     let status = Command::new("cmake")
-        .args([
-            "..",
-            "-DBUILD_SHARED_LIBS=OFF",
-            "-DCMAKE_BUILD_TYPE=Release",
-            "-DDRACO_TESTS=OFF",
-            &format!("-DCMAKE_INSTALL_PREFIX={}", "install"),
-        ])
+        .args(&configure_args)
         .current_dir(&draco_build)
         .status()
         .expect("Failed to run CMake");
     assert!(status.success(), "CMake configuration failed");
 
-    let (build_args, install_args) = if target.contains("windows-msvc") {
-        (
-            vec!["--build", ".", "--config", "Release"],
-            vec!["--install", ".", "--config", "Release"],
-        )
-    } else {
-        (vec!["--build", "."], vec!["--install", "."])
-    };
+    let jobs = std::env::var("NUM_JOBS").unwrap_or_else(|_| "1".to_string());
+    let mut build_args = vec!["--build", ".", "--parallel", &jobs];
+    let mut install_args = vec!["--install", "."];
+    if msvc {
+        build_args.extend(["--config", "Release"]);
+        install_args.extend(["--config", "Release"]);
+    }
+    // Only libdraco, without the encoder and decoder tools. Installing would
+    // need the tools, so link the library from the build directory.
+    if decoder_only {
+        build_args.extend(["--target", "draco"]);
+    }
 
     run_cmake_command(&build_args, &draco_build, "build");
-    run_cmake_command(&install_args, &draco_build, "install");
+    if !decoder_only {
+        run_cmake_command(&install_args, &draco_build, "install");
+    }
 
     let mut build = cxx_build::bridge("src/ffi.rs");
     build
         .file("cpp/decoder_api.cc")
+        .file("cpp/heap_budget.cc")
+        .file("cpp/thread_pool.cc")
+        .file("cpp/vertex_cache.cc")
         .include("include")
         .include("third_party/draco/src")
         .include("third_party/draco/build")
@@ -73,16 +137,101 @@ fn main() {
         build.flag("-mmacosx-version-min=15.5");
     }
 
+    // The perf feature also reports the C++ heap allocations of each decode.
+    if feature("PERF") {
+        build.define("DRACO_DECODER_PERF", None);
+    }
+    // Replaces operator new to track the C++ heap of every decode.
+    if feature("HEAP_BUDGET") {
+        build.define("DRACO_DECODER_HEAP_BUDGET", None);
+    }
+
+    for flag in &cxx_flags {
+        build.flag(flag);
+    }
+    if thin_lto {
+        build.flag("-flto=thin");
+        // GNU ar cannot index bitcode objects.
+        if !target.contains("apple") && std::env::var_os("AR").is_none() {
+            build.archiver("llvm-ar");
+        }
+    }
+
     build.compile("decoder_api");
 
-    if target.contains("windows-msvc") {
+    if msvc {
         println!("cargo:rustc-link-search=native={draco_install}");
+    } else if decoder_only {
+        println!("cargo:rustc-link-search=native={draco_build}");
     } else {
         println!("cargo:rustc-link-search=native={draco_install}/lib");
     }
     println!("cargo:rustc-link-lib=static=draco");
 
+    // The function sections of decoder-only only shrink a link that collects
+    // unused sections. rustc asks for that in every final link unless
+    // -C link-dead-code is set; this only affects the tests, benches and
+    // examples of this package, Cargo does not pass it on to dependents.
+    if decoder_only && let Some(flag) = section_gc_flag(&target) {
+        println!("cargo:rustc-link-arg={flag}");
+    }
+
     println!("cargo:rerun-if-changed=cpp/decoder_api.cc");
+    println!("cargo:rerun-if-changed=cpp/heap_budget.cc");
+    println!("cargo:rerun-if-changed=cpp/heap_budget.h");
+    println!("cargo:rerun-if-changed=cpp/thread_pool.cc");
+    println!("cargo:rerun-if-changed=cpp/thread_pool.h");
+    println!("cargo:rerun-if-changed=cpp/vertex_cache.cc");
+    println!("cargo:rerun-if-changed=cpp/vertex_cache.h");
     println!("cargo:rerun-if-changed=include/decoder_api.h");
     println!("cargo:rerun-if-changed=src/ffi.rs");
 }
+
+/// The linker flag that drops unreferenced sections on `target`, if known.
+fn section_gc_flag(target: &str) -> Option<&'static str> {
+    if target.contains("windows-msvc") {
+        Some("/OPT:REF")
+    } else if target.contains("apple") {
+        Some("-Wl,-dead_strip")
+    } else if ["linux", "android", "freebsd", "netbsd", "openbsd"]
+        .iter()
+        .any(|os| target.contains(os))
+    {
+        Some("-Wl,--gc-sections")
+    } else {
+        None
+    }
+}
+
+fn feature(name: &str) -> bool {
+    std::env::var_os(format!("CARGO_FEATURE_{name}")).is_some()
+}
+
+/// The `-march` target from `DRACO_DECODER_MARCH` (e.g. `x86-64-v3`, or
+/// `AVX2` for MSVC's `/arch`), else `native` with the `native-cpu` feature.
+fn target_cpu() -> Option<String> {
+    println!("cargo:rerun-if-env-changed=DRACO_DECODER_MARCH");
+    std::env::var("DRACO_DECODER_MARCH")
+        .ok()
+        .filter(|cpu| !cpu.is_empty())
+        .or_else(|| feature("NATIVE_CPU").then(|| "native".to_string()))
+}
+
+/// ThinLTO objects are LLVM bitcode, so both the C++ compiler and the final
+/// link must be LLVM's. Falls back to a normal build otherwise, so that
+/// `--all-features` still builds everywhere.
+fn thin_lto_supported(target: &str) -> bool {
+    let compiler = cc::Build::new().cpp(true).get_compiler();
+    let rustflags = std::env::var("CARGO_ENCODED_RUSTFLAGS").unwrap_or_default();
+    let reason = if target.contains("windows-msvc") {
+        "is not supported on MSVC"
+    } else if !compiler.is_like_clang() {
+        "needs clang as the C++ compiler (CXX=clang++)"
+    } else if !rustflags.contains("linker-plugin-lto") {
+        "needs RUSTFLAGS=\"-Clinker-plugin-lto -Clinker=clang -Clink-arg=-fuse-ld=lld\""
+    } else {
+        return true;
+    };
+    println!("cargo:warning=thin-lto {reason}, building without LTO");
+    false
+}
@@ -1,19 +1,56 @@
 #include "decoder_api.h"
 #include "draco_decoder/src/ffi.rs.h"
+#include "heap_budget.h"
+#include "thread_pool.h"
+#include "vertex_cache.h"
 
+#include "draco/attributes/attribute_quantization_transform.h"
 #include "draco/attributes/geometry_attribute.h"
 #include "draco/attributes/point_attribute.h"
 #include "draco/compression/decode.h"
 #include "draco/compression/mesh/mesh_decoder.h"
+#include "draco/compression/mesh/mesh_edgebreaker_decoder.h"
+#include "draco/compression/mesh/mesh_sequential_decoder.h"
 #include "draco/compression/point_cloud/point_cloud_decoder.h"
 #include "draco/core/decoder_buffer.h"
 #include "draco/mesh/mesh.h"
 #include "draco/point_cloud/point_cloud.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
 
-// DracoMesh implementation
-DracoMesh::DracoMesh(std::unique_ptr<draco::Mesh> m) : mesh(std::move(m)) {}
-DracoMesh::~DracoMesh() = default;
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE4_1__)
+#include <smmintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#elif defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#endif
+
+// DracoPointCloud implementation
+DracoPointCloud::DracoPointCloud(std::unique_ptr<draco::PointCloud> p)
+    : pc(std::move(p)) {}
+DracoPointCloud::~DracoPointCloud() = default;
+
+using Clock = std::chrono::steady_clock;
+
+static uint64_t elapsed_ns(Clock::time_point start) {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() -
+                                                           start)
+          .count());
+}
 
 static size_t sizeof_data_type(draco::DataType type) {
   switch (type) {
@@ -36,103 +73,920 @@ static size_t sizeof_data_type(draco::DataType type) {
   }
 }
 
-rust::Vec<uint8_t> decode_point_cloud(rust::Slice<const uint8_t> data) {
-  draco::DecoderBuffer buffer;
-  buffer.Init(reinterpret_cast<const char *>(data.data()), data.size());
+// Maps a Draco attribute type to the id reported in MeshAttribute.
+static uint32_t attribute_type_id(draco::GeometryAttribute::Type type) {
+  switch (type) {
+  case draco::GeometryAttribute::POSITION:
+    return 0;
+  case draco::GeometryAttribute::NORMAL:
+    return 1;
+  case draco::GeometryAttribute::COLOR:
+    return 2;
+  case draco::GeometryAttribute::TEX_COORD:
+    return 3;
+  case draco::GeometryAttribute::GENERIC:
+    return 4;
+  default:
+    return 255; // Unknown
+  }
+}
 
-  draco::Decoder decoder;
-  auto status_or_geometry = decoder.DecodePointCloudFromBuffer(&buffer);
-  if (!status_or_geometry.ok()) {
-    return {};
+// Maps a C++ scalar type to the Draco data type with the same layout.
+template <typename T> struct DracoDataType;
+template <> struct DracoDataType<int8_t> {
+  static constexpr draco::DataType value = draco::DT_INT8;
+};
+template <> struct DracoDataType<uint8_t> {
+  static constexpr draco::DataType value = draco::DT_UINT8;
+};
+template <> struct DracoDataType<int16_t> {
+  static constexpr draco::DataType value = draco::DT_INT16;
+};
+template <> struct DracoDataType<uint16_t> {
+  static constexpr draco::DataType value = draco::DT_UINT16;
+};
+template <> struct DracoDataType<int32_t> {
+  static constexpr draco::DataType value = draco::DT_INT32;
+};
+template <> struct DracoDataType<uint32_t> {
+  static constexpr draco::DataType value = draco::DT_UINT32;
+};
+template <> struct DracoDataType<float> {
+  static constexpr draco::DataType value = draco::DT_FLOAT32;
+};
+template <> struct DracoDataType<double> {
+  static constexpr draco::DataType value = draco::DT_FLOAT64;
+};
+
+// Maximum number of components converted with a stack buffer.
+constexpr int kMaxConvertComponents = 16;
+
+// Writes the values of points [begin, end) of `attr` to `out` as `T`, placing
+// consecutive values `out_stride` bytes apart. The caller has already checked
+// that `out` holds `(end - begin) * out_stride` bytes. `Dim` is the number of
+// components of `attr` if known at compile time, so the copies below have a
+// constant size, or 0 to read it from `attr`. Returns false if a conversion
+// would need more than kMaxConvertComponents components.
+template <typename T, int Dim = 0>
+static bool write_attribute_values(const draco::PointAttribute &attr,
+                                   uint32_t begin, uint32_t end, uint8_t *out,
+                                   size_t out_stride) {
+  const int dim = Dim > 0 ? Dim : attr.num_components();
+  const size_t value_size = dim * sizeof(T);
+
+  if (attr.data_type() != DracoDataType<T>::value) {
+    // Stored type differs from the output type, convert value by value. The
+    // output may be unaligned for `T` in interleaved layouts, so convert into
+    // a local value first.
+    if (dim > kMaxConvertComponents)
+      return false;
+    T value[kMaxConvertComponents];
+    if (attr.data_type() == draco::DT_UINT32 && std::is_unsigned<T>::value) {
+      // Quantized values are stored as u32 and fit the narrower output type,
+      // so narrow them directly instead of through ConvertValue.
+      uint32_t src[kMaxConvertComponents];
+      for (draco::PointIndex i(begin); i < end; ++i) {
+        memcpy(src, attr.GetAddress(attr.mapped_index(i)),
+               dim * sizeof(uint32_t));
+        for (int c = 0; c < dim; ++c) {
+          value[c] = static_cast<T>(src[c]);
+        }
+        memcpy(out, value, value_size);
+        out += out_stride;
+      }
+      return true;
+    }
+    for (draco::PointIndex i(begin); i < end; ++i) {
+      attr.ConvertValue<T>(attr.mapped_index(i), static_cast<int8_t>(dim),
+                           value);
+      memcpy(out, value, value_size);
+      out += out_stride;
+    }
+    return true;
   }
 
-  std::unique_ptr<draco::PointCloud> pc = std::move(status_or_geometry).value();
+  // Tightly packed values with identity mapping are already laid out exactly
+  // like a tightly packed output, so the whole range is copied at once.
+  if (out_stride == value_size && attr.is_mapping_identity() &&
+      attr.byte_stride() == static_cast<int64_t>(value_size) &&
+      attr.size() >= static_cast<size_t>(end)) {
+    memcpy(out, attr.GetAddress(draco::AttributeValueIndex(begin)),
+           value_size * (end - begin));
+    return true;
+  }
 
-  const draco::PointAttribute *attr =
-      pc->GetNamedAttribute(draco::GeometryAttribute::POSITION);
-  if (!attr) {
-    return {};
+  for (draco::PointIndex i(begin); i < end; ++i) {
+    memcpy(out, attr.GetAddress(attr.mapped_index(i)), value_size);
+    out += out_stride;
+  }
+  return true;
+}
+
+// Writes points [begin, end) of an attribute to `out`, `out_stride` bytes
+// apart. Returns false if the values cannot be written.
+using WriteRangeFn = bool (*)(const draco::PointAttribute &attr,
+                              uint32_t begin, uint32_t end, uint8_t *out,
+                              size_t out_stride);
+
+// Returns the writer of `T` values with `dim` components, specialized for the
+// common vector sizes.
+template <typename T> static WriteRangeFn values_writer(int dim) {
+  switch (dim) {
+  case 1:
+    return write_attribute_values<T, 1>;
+  case 2:
+    return write_attribute_values<T, 2>;
+  case 3:
+    return write_attribute_values<T, 3>;
+  case 4:
+    return write_attribute_values<T, 4>;
+  default:
+    return write_attribute_values<T>;
+  }
+}
+
+// Returns the writer of `dim` component values of `type`, or nullptr if the
+// data type is unsupported.
+static WriteRangeFn attribute_writer(draco::DataType type, int dim) {
+  switch (type) {
+  case draco::DT_INT8:
+    return values_writer<int8_t>(dim);
+  case draco::DT_UINT8:
+    return values_writer<uint8_t>(dim);
+  case draco::DT_INT16:
+    return values_writer<int16_t>(dim);
+  case draco::DT_UINT16:
+    return values_writer<uint16_t>(dim);
+  case draco::DT_INT32:
+    return values_writer<int32_t>(dim);
+  case draco::DT_UINT32:
+    return values_writer<uint32_t>(dim);
+  case draco::DT_FLOAT32:
+    return values_writer<float>(dim);
+  case draco::DT_FLOAT64:
+    return values_writer<double>(dim);
+  default:
+    return nullptr;
   }
+}
 
-  rust::Vec<uint8_t> out;
-  for (draco::PointIndex i(0); i < pc->num_points(); ++i) {
-    float point[3] = {0.0f};
-    attr->GetValue(attr->mapped_index(i), &point[0]);
-    uint8_t *ptr = reinterpret_cast<uint8_t *>(point);
-    for (size_t j = 0; j < sizeof(point); ++j) {
-      out.push_back(ptr[j]);
+// Writes points [begin, end) of `attr` to `out` as `type`, `out_stride` bytes
+// apart. Returns false if the data type is unsupported.
+static bool write_attribute_range(const draco::PointAttribute &attr,
+                                  draco::DataType type, uint32_t begin,
+                                  uint32_t end, uint8_t *out,
+                                  size_t out_stride) {
+  const WriteRangeFn write = attribute_writer(type, attr.num_components());
+  return write && write(attr, begin, end, out, out_stride);
+}
+
+// Writes points [begin, end) of `attr`, whose quantization transform was
+// skipped by the decoder, to `out` as dequantized floats, `out_stride` bytes
+// apart. Returns false if `attr` is not quantized.
+static bool write_dequantized_range(const draco::PointAttribute &attr,
+                                    uint32_t begin, uint32_t end, uint8_t *out,
+                                    size_t out_stride) {
+  draco::AttributeQuantizationTransform transform;
+  const int dim = attr.num_components();
+  if (!transform.InitFromAttribute(attr) || dim > kMaxConvertComponents)
+    return false;
+
+  // Same mapping as draco::Dequantizer.
+  const uint32_t max_quantized = (1u << transform.quantization_bits()) - 1;
+  const float delta = transform.range() / static_cast<float>(max_quantized);
+  uint32_t quantized[kMaxConvertComponents];
+  float value[kMaxConvertComponents];
+  for (draco::PointIndex i(begin); i < end; ++i) {
+    attr.ConvertValue<uint32_t>(attr.mapped_index(i), static_cast<int8_t>(dim),
+                                quantized);
+    for (int c = 0; c < dim; ++c) {
+      value[c] = transform.min_value(c) + quantized[c] * delta;
+    }
+    memcpy(out, value, dim * sizeof(float));
+    out += out_stride;
+  }
+  return true;
+}
+
+// Normal formats of DecodeOptions::normal_format.
+constexpr uint32_t kNormalFloat32 = 0;
+constexpr uint32_t kNormalOct16 = 1;
+constexpr uint32_t kNormalOct8 = 2;
+constexpr uint32_t kNormalSnorm16 = 3;
+constexpr uint32_t kNormalSnorm8 = 4;
+
+// Number of normals converted at once by write_normal_values.
+constexpr uint32_t kNormalBatch = 16;
+
+// Scales `v`, clamped to [-1, 1], to a signed normalized integer of magnitude
+// `max`, rounded half away from zero by the truncating cast of the caller.
+static inline float to_snorm(float v, float max) {
+  v = std::min(std::max(v, -1.0f), 1.0f) * max;
+  return v + std::copysign(0.5f, v);
+}
+
+// Writes the normals of points [begin, end) of `attr` to `out` as
+// `out_components` signed normalized `T`s, `out_stride` bytes apart. Octahedral
+// output uses the usual mapping of the upper hemisphere onto the inner diamond
+// of the unit square, with the lower hemisphere folded over the edges. Normals
+// are gathered into batches of planar x/y/z arrays so the branchless math
+// below compiles to SIMD code. Returns false if `attr` is not 3D.
+template <typename T>
+static bool write_normal_values(const draco::PointAttribute &attr,
+                                bool octahedral, int out_components,
+                                uint32_t begin, uint32_t end, uint8_t *out,
+                                size_t out_stride) {
+  if (attr.num_components() != 3)
+    return false;
+  const float max = static_cast<float>(std::numeric_limits<T>::max());
+  const bool is_float = attr.data_type() == draco::DT_FLOAT32;
+  float x[kNormalBatch], y[kNormalBatch], z[kNormalBatch];
+  for (uint32_t first = begin; first < end; first += kNormalBatch) {
+    const uint32_t n = std::min(kNormalBatch, end - first);
+    for (uint32_t k = 0; k < kNormalBatch; ++k) {
+      // The tail of the last batch is converted from zero vectors.
+      float value[3] = {0.0f, 0.0f, 0.0f};
+      if (k < n) {
+        const draco::AttributeValueIndex index =
+            attr.mapped_index(draco::PointIndex(first + k));
+        if (is_float) {
+          memcpy(value, attr.GetAddress(index), sizeof(value));
+        } else {
+          attr.ConvertValue<float>(index, 3, value);
+        }
+      }
+      x[k] = value[0];
+      y[k] = value[1];
+      z[k] = value[2];
+    }
+
+    if (octahedral) {
+      for (uint32_t k = 0; k < kNormalBatch; ++k) {
+        const float norm = std::abs(x[k]) + std::abs(y[k]) + std::abs(z[k]);
+        const float inv = norm > 0.0f ? 1.0f / norm : 0.0f;
+        const float px = x[k] * inv;
+        const float py = y[k] * inv;
+        const float fx = (1.0f - std::abs(py)) * std::copysign(1.0f, px);
+        const float fy = (1.0f - std::abs(px)) * std::copysign(1.0f, py);
+        x[k] = to_snorm(z[k] < 0.0f ? fx : px, max);
+        y[k] = to_snorm(z[k] < 0.0f ? fy : py, max);
+      }
+    } else {
+      for (uint32_t k = 0; k < kNormalBatch; ++k) {
+        x[k] = to_snorm(x[k], max);
+        y[k] = to_snorm(y[k], max);
+        z[k] = to_snorm(z[k], max);
+      }
+    }
+
+    for (uint32_t k = 0; k < n; ++k) {
+      const T value[4] = {static_cast<T>(x[k]), static_cast<T>(y[k]),
+                          static_cast<T>(z[k]), 0};
+      memcpy(out, value, out_components * sizeof(T));
+      out += out_stride;
     }
   }
-  return out;
+  return true;
 }
 
+// write_normal_values with the output format fixed, as a WriteRangeFn.
+template <typename T, bool Octahedral, int Components>
+static bool write_normals(const draco::PointAttribute &attr, uint32_t begin,
+                          uint32_t end, uint8_t *out, size_t out_stride) {
+  return write_normal_values<T>(attr, Octahedral, Components, begin, end, out,
+                                out_stride);
+}
 
-std::unique_ptr<DracoMesh> create_mesh(rust::Slice<const uint8_t> data) {
+// Returns the writer of normals in `format`, or nullptr if the format is
+// unsupported.
+static WriteRangeFn normal_writer(uint32_t format) {
+  switch (format) {
+  case kNormalOct16:
+    return write_normals<int16_t, true, 2>;
+  case kNormalOct8:
+    return write_normals<int8_t, true, 2>;
+  case kNormalSnorm16:
+    return write_normals<int16_t, false, 3>;
+  case kNormalSnorm8:
+    return write_normals<int8_t, false, 4>;
+  default:
+    return nullptr;
+  }
+}
+
+// Returns the size in bytes of one value of `attr`.
+static size_t attribute_value_size(const draco::PointAttribute &attr) {
+  return static_cast<size_t>(attr.num_components()) *
+         sizeof_data_type(attr.data_type());
+}
+
+// Narrows `count` vertex indices to 16 bits. Every value must be below 65536,
+// which holds whenever the u16 index format was selected.
+static void narrow_indices_u16(const uint32_t *src, size_t count,
+                               uint16_t *dst) {
+  size_t i = 0;
+#if defined(__AVX2__)
+  for (; i + 16 <= count; i += 16) {
+    const __m256i a =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+    const __m256i b =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i + 8));
+    // packus works per 128-bit lane, restore the order of the 64-bit blocks.
+    const __m256i packed =
+        _mm256_permute4x64_epi64(_mm256_packus_epi32(a, b), 0xD8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), packed);
+  }
+#elif defined(__SSE4_1__)
+  for (; i + 8 <= count; i += 8) {
+    const __m128i a =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    const __m128i b =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i + 4));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i),
+                     _mm_packus_epi32(a, b));
+  }
+#elif defined(__SSE2__) || defined(_M_X64)
+  // SSE2 only has a signed 32->16 pack, so bias the values into the signed
+  // range before packing and remove the bias afterwards.
+  const __m128i bias32 = _mm_set1_epi32(0x8000);
+  const __m128i bias16 = _mm_set1_epi16(static_cast<short>(0x8000));
+  for (; i + 8 <= count; i += 8) {
+    const __m128i a = _mm_sub_epi32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i)), bias32);
+    const __m128i b = _mm_sub_epi32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i + 4)),
+        bias32);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i),
+                     _mm_add_epi16(_mm_packs_epi32(a, b), bias16));
+  }
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+  for (; i + 8 <= count; i += 8) {
+    const uint16x4_t lo = vmovn_u32(vld1q_u32(src + i));
+    const uint16x4_t hi = vmovn_u32(vld1q_u32(src + i + 4));
+    vst1q_u16(dst + i, vcombine_u16(lo, hi));
+  }
+#elif defined(__wasm_simd128__)
+  for (; i + 8 <= count; i += 8) {
+    const v128_t a = wasm_v128_load(src + i);
+    const v128_t b = wasm_v128_load(src + i + 4);
+    wasm_v128_store(dst + i, wasm_u16x8_narrow_i32x4(a, b));
+  }
+#endif
+  for (; i < count; ++i) {
+    dst[i] = static_cast<uint16_t>(src[i]);
+  }
+}
+
+// Narrows `count` vertex indices to 8 bits. Every value must be below 256,
+// which holds whenever the u8 index format was selected. Only tiny meshes use
+// it, so the plain loop is left to the auto-vectorizer.
+static void narrow_indices_u8(const uint32_t *src, size_t count,
+                              uint8_t *dst) {
+  for (size_t i = 0; i < count; ++i) {
+    dst[i] = static_cast<uint8_t>(src[i]);
+  }
+}
+
+// Writes the indices of faces [begin, end) of `mesh` to `out` as
+// `index_size` byte integers. The caller has already checked that `out` is
+// large enough.
+static void write_index_range(const draco::Mesh &mesh, size_t index_size,
+                              uint32_t begin, uint32_t end, uint8_t *out) {
+  // Faces are stored as contiguous triples of 32-bit point indices.
+  static_assert(sizeof(draco::Mesh::Face) == 3 * sizeof(uint32_t),
+                "unexpected draco::Mesh::Face layout");
+
+  if (begin >= end)
+    return;
+
+  const size_t count = static_cast<size_t>(end - begin) * 3;
+  const uint32_t *src = reinterpret_cast<const uint32_t *>(
+      mesh.face(draco::FaceIndex(begin)).data());
+  if (index_size == sizeof(uint8_t)) {
+    narrow_indices_u8(src, count, out);
+  } else if (index_size == sizeof(uint16_t)) {
+    narrow_indices_u16(src, count, reinterpret_cast<uint16_t *>(out));
+  } else {
+    memcpy(out, src, count * sizeof(uint32_t));
+  }
+}
+
+// Attributes of a point cloud in output order.
+using AttributeList = std::vector<const draco::PointAttribute *>;
+
+// Fills `attrs` with the attributes of `pc` in output order, sorted by
+// unique_id. Reuses the storage of `attrs`.
+static void sort_attributes(const draco::PointCloud &pc, AttributeList &attrs) {
+  attrs.clear();
+  attrs.reserve(pc.num_attributes());
+  for (int i = 0; i < pc.num_attributes(); ++i) {
+    attrs.push_back(pc.attribute(i));
+  }
+  std::sort(attrs.begin(), attrs.end(),
+            [](const draco::PointAttribute *a, const draco::PointAttribute *b) {
+              return a->unique_id() < b->unique_id();
+            });
+}
+
+// Returns the attributes of `pc` in output order, sorted by unique_id.
+static AttributeList sorted_attributes(const draco::PointCloud &pc) {
+  AttributeList attrs;
+  sort_attributes(pc, attrs);
+  return attrs;
+}
+
+// Copies the code and message of a failed Draco call into `status`.
+static void set_status(DracoStatus *status, const draco::Status &error) {
+  if (!status)
+    return;
+  status->code = static_cast<int32_t>(error.code());
+  status->message = rust::String::lossy(error.error_msg_string());
+}
+
+// Decodes the mesh in `data`, or returns nullptr and fills `status`, if set,
+// with the reason.
+static std::unique_ptr<draco::Mesh>
+decode_mesh(draco::Decoder &decoder, const uint8_t *data, size_t size,
+            DracoStatus *status = nullptr) {
   draco::DecoderBuffer buffer;
-  buffer.Init(reinterpret_cast<const char *>(data.data()), data.size());
+  buffer.Init(reinterpret_cast<const char *>(data), size);
 
-  draco::Decoder decoder;
   auto status_or_geometry = decoder.DecodeMeshFromBuffer(&buffer);
   if (!status_or_geometry.ok()) {
+    set_status(status, status_or_geometry.status());
     return nullptr;
   }
+  return std::move(status_or_geometry).value();
+}
 
-  std::unique_ptr<draco::Mesh> mesh = std::move(status_or_geometry).value();
-  return std::make_unique<DracoMesh>(std::move(mesh));
+// Bit of DecodeOptions::attribute_types used for types without an id of
+// their own.
+constexpr uint32_t kUnknownAttributeTypeBit = 5;
+
+// Returns the bit of `type` in DecodeOptions::attribute_types.
+static uint32_t attribute_type_bit(draco::GeometryAttribute::Type type) {
+  const uint32_t id = attribute_type_id(type);
+  return 1u << std::min(id, kUnknownAttributeTypeBit);
 }
 
-bool compute_mesh_config(const DracoMesh &draco_mesh, MeshConfig &config) {
-  const draco::Mesh *mesh = draco_mesh.mesh.get();
+static bool has_attribute_filter(const DecodeOptions &options) {
+  return options.attribute_types != 0 || !options.attribute_ids.empty();
+}
+
+// Returns true if `attr` passes the attribute filter of `options`. Without a
+// filter every attribute is selected.
+static bool is_attribute_selected(const draco::PointAttribute &attr,
+                                  const DecodeOptions &options) {
+  if (!has_attribute_filter(options) ||
+      (options.attribute_types & attribute_type_bit(attr.attribute_type())))
+    return true;
+  for (uint32_t unique_id : options.attribute_ids) {
+    if (unique_id == attr.unique_id())
+      return true;
+  }
+  return false;
+}
+
+uint32_t skipped_transform_types(const DecodeOptions &options) {
+  // An id filter may select attributes of any type.
+  if (options.attribute_types == 0 || !options.attribute_ids.empty())
+    return 0;
+  uint32_t types = 0;
+  for (int i = draco::GeometryAttribute::POSITION;
+       i < draco::GeometryAttribute::NAMED_ATTRIBUTES_COUNT; ++i) {
+    const auto type = static_cast<draco::GeometryAttribute::Type>(i);
+    types |= attribute_type_bit(type) & ~options.attribute_types;
+  }
+  return types;
+}
+
+// Skips the output transform, e.g. dequantization, of every attribute type
+// skipped_transform_types returns for `options`.
+static void skip_unselected_transforms(draco::Decoder &decoder,
+                                       const DecodeOptions &options) {
+  const uint32_t skipped = skipped_transform_types(options);
+  for (int i = draco::GeometryAttribute::POSITION;
+       i < draco::GeometryAttribute::NAMED_ATTRIBUTES_COUNT; ++i) {
+    const auto type = static_cast<draco::GeometryAttribute::Type>(i);
+    if (skipped & attribute_type_bit(type))
+      decoder.SetSkipAttributeTransform(type);
+  }
+}
+
+// Deletes the attributes of `pc` that the filter of `options` excludes, so
+// their buffers are freed right after the decode.
+static void delete_unselected_attributes(draco::PointCloud &pc,
+                                         const DecodeOptions &options) {
+  if (!has_attribute_filter(options))
+    return;
+  for (int i = pc.num_attributes() - 1; i >= 0; --i) {
+    if (!is_attribute_selected(*pc.attribute(i), options))
+      pc.DeleteAttribute(i);
+  }
+}
+
+// Skips the dequantization of every attribute type that can be kept
+// quantized. Normals use the octahedron transform instead and are always
+// decoded.
+static void skip_quantization_transforms(draco::Decoder &decoder,
+                                         const DecodeOptions &options) {
+  if (!options.keep_quantized)
+    return;
+  decoder.SetSkipAttributeTransform(draco::GeometryAttribute::POSITION);
+  decoder.SetSkipAttributeTransform(draco::GeometryAttribute::TEX_COORD);
+  decoder.SetSkipAttributeTransform(draco::GeometryAttribute::COLOR);
+  decoder.SetSkipAttributeTransform(draco::GeometryAttribute::GENERIC);
+}
+
+// Reorders the faces of `mesh` for post-transform vertex cache reuse and
+// renumbers its points in order of first use. Only the face list and the point
+// to value mapping of every attribute change; the values are gathered in the
+// new order while the output is written, so no extra pass touches them.
+static void optimize_vertex_order(draco::Mesh &mesh) {
+  const uint32_t num_faces = mesh.num_faces();
+  const uint32_t num_points = mesh.num_points();
+  if (num_faces < 2)
+    return;
+
+  std::vector<uint32_t> indices(static_cast<size_t>(num_faces) * 3);
+  for (uint32_t f = 0; f < num_faces; ++f) {
+    const draco::Mesh::Face &face = mesh.face(draco::FaceIndex(f));
+    for (int c = 0; c < 3; ++c) {
+      indices[f * 3 + c] = face[c].value();
+    }
+  }
+  optimize_vertex_cache(indices.data(), indices.size(), num_points);
+  std::vector<uint32_t> remap(num_points);
+  build_vertex_fetch_remap(indices.data(), indices.size(), num_points,
+                           remap.data());
+
+  for (uint32_t f = 0; f < num_faces; ++f) {
+    draco::Mesh::Face face;
+    for (int c = 0; c < 3; ++c) {
+      face[c] = draco::PointIndex(remap[indices[f * 3 + c]]);
+    }
+    mesh.SetFace(draco::FaceIndex(f), face);
+  }
+
+  std::vector<draco::AttributeValueIndex> values(num_points);
+  for (int i = 0; i < mesh.num_attributes(); ++i) {
+    draco::PointAttribute &attr = *mesh.attribute(i);
+    for (uint32_t p = 0; p < num_points; ++p) {
+      values[remap[p]] = attr.mapped_index(draco::PointIndex(p));
+    }
+    attr.SetExplicitMapping(num_points);
+    for (uint32_t p = 0; p < num_points; ++p) {
+      attr.SetPointMapEntry(draco::PointIndex(p), values[p]);
+    }
+  }
+}
+
+std::unique_ptr<DracoMesh> create_mesh(rust::Slice<const uint8_t> data,
+                                       const DecodeOptions &options,
+                                       DracoStatus &status) {
+  draco::Decoder decoder;
+  skip_unselected_transforms(decoder, options);
+  skip_quantization_transforms(decoder, options);
+  std::unique_ptr<draco::Mesh> mesh =
+      decode_mesh(decoder, data.data(), data.size(), &status);
   if (!mesh) {
-    return false;
+    return nullptr;
   }
+  delete_unselected_attributes(*mesh, options);
+  if (options.optimize_vertex_cache)
+    optimize_vertex_order(*mesh);
+  return std::make_unique<DracoMesh>(std::move(mesh));
+}
 
-  // Basic info
-  config.vertex_count = mesh->num_points();
-  config.index_count = mesh->num_faces() * 3;
+#ifdef DRACO_DECODER_PERF
+std::unique_ptr<DracoMesh>
+create_mesh_with_stats(rust::Slice<const uint8_t> data, DecodeStats &stats) {
+  const uint64_t allocations = allocation_count();
+  const Clock::time_point start = Clock::now();
+  DracoStatus status{};
+  std::unique_ptr<DracoMesh> mesh = create_mesh(data, DecodeOptions{}, status);
+  stats.parse_ns = elapsed_ns(start);
+  stats.bytes_in = data.size();
+  stats.allocations += allocation_count() - allocations;
+  return mesh;
+}
+#endif
 
-  // Index length
-  if (config.index_count <=
-      static_cast<uint32_t>(std::numeric_limits<uint16_t>::max())) {
-    config.index_length = config.index_count * sizeof(uint16_t);
-  } else {
-    config.index_length = config.index_count * sizeof(uint32_t);
+// Vertex layouts of DecodeOptions::layout.
+constexpr uint32_t kLayoutPlanar = 0;
+constexpr uint32_t kLayoutInterleaved = 1;
+constexpr uint32_t kLayoutGrouped = 2;
+
+// Placement of one attribute in the output buffer.
+struct AttributePlacement {
+  // Byte offset of the value of the first point
+  size_t offset = 0;
+  // Bytes between the values of consecutive points
+  size_t stride = 0;
+  // Data type and number of components the values are written in
+  draco::DataType data_type = draco::DT_INVALID;
+  int num_components = 0;
+  // Quantization bits of values kept quantized, 0 otherwise
+  int32_t quantization_bits = 0;
+  // Set for quantized values that are written as dequantized floats
+  bool dequantize = false;
+  // Packed format of normals, kNormalFloat32 if written as stored
+  uint32_t normal_format = kNormalFloat32;
+  // Writer of the values in the format above, nullptr if unsupported
+  WriteRangeFn write = nullptr;
+};
+
+// A run of the output holding one or more attributes interleaved per point.
+struct VertexBlock {
+  size_t offset = 0;
+  size_t stride = 0;
+  // True if alignment leaves gaps inside a vertex, which are zeroed.
+  bool has_padding = false;
+  // Indices into MeshLayout::attributes, in vertex order
+  std::vector<size_t> members;
+};
+
+// Output layout of a decoded geometry: the index block followed by the vertex
+// blocks. Computed once per set of options, it is the decode plan every write
+// of the geometry follows.
+struct MeshLayout {
+  uint32_t num_points = 0;
+  uint32_t num_faces = 0;
+  // Size in bytes of one index
+  size_t index_size = sizeof(uint16_t);
+  size_t index_length = 0;
+  // Attributes in config order, sorted by unique_id
+  AttributeList attributes;
+  // Placement of each entry of `attributes`
+  std::vector<AttributePlacement> placements;
+  // Vertex blocks in buffer order
+  std::vector<VertexBlock> blocks;
+  size_t buffer_size = 0;
+};
+
+// DracoMesh and DecoderContext implementation, after MeshLayout is complete
+DracoMesh::DracoMesh(std::unique_ptr<draco::Mesh> m) : mesh(std::move(m)) {}
+DracoMesh::~DracoMesh() = default;
+
+DecoderContext::DecoderContext()
+    : decoder(std::make_unique<draco::Decoder>()),
+      layout(std::make_unique<MeshLayout>()) {}
+DecoderContext::~DecoderContext() = default;
+
+static size_t align_up(size_t value, size_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+static bool is_valid_alignment(uint32_t alignment) {
+  return alignment == 0 || (alignment & (alignment - 1)) == 0;
+}
+
+// Returns the index of the attribute with `unique_id` in `attrs`, or
+// attrs.size() if there is none.
+static size_t find_attribute(const AttributeList &attrs, uint32_t unique_id) {
+  for (size_t i = 0; i < attrs.size(); ++i) {
+    if (attrs[i]->unique_id() == unique_id)
+      return i;
+  }
+  return attrs.size();
+}
+
+// Maximum number of components of an attribute kept quantized, bounded by the
+// origin reported in MeshAttribute.
+constexpr int kMaxQuantizedComponents = 4;
+
+// Sets the output data type of `attr` in `placement`. 3D normals are packed as
+// requested by `options`. Attributes whose quantization transform was skipped
+// by the decoder hold quantized values; they are narrowed to the smallest
+// unsigned type that fits their bits, or dequantized to float if they have
+// more components than MeshAttribute can describe.
+static void set_output_format(const draco::PointAttribute &attr,
+                              const DecodeOptions &options,
+                              AttributePlacement &placement) {
+  placement.num_components = attr.num_components();
+  if (options.normal_format != kNormalFloat32 &&
+      attr.attribute_type() == draco::GeometryAttribute::NORMAL &&
+      attr.num_components() == 3) {
+    const uint32_t format = options.normal_format;
+    placement.normal_format = format;
+    placement.data_type =
+        format == kNormalOct16 || format == kNormalSnorm16 ? draco::DT_INT16
+                                                           : draco::DT_INT8;
+    placement.num_components = format == kNormalOct16 || format == kNormalOct8
+                                   ? 2
+                                   : format == kNormalSnorm16 ? 3 : 4;
+    return;
+  }
+
+  draco::AttributeQuantizationTransform transform;
+  if (!transform.InitFromAttribute(attr)) {
+    placement.data_type = attr.data_type();
+    return;
+  }
+  if (attr.num_components() > kMaxQuantizedComponents) {
+    placement.data_type = draco::DT_FLOAT32;
+    placement.dequantize = true;
+    return;
   }
+  const int32_t bits = transform.quantization_bits();
+  placement.quantization_bits = bits;
+  placement.data_type = bits <= 8    ? draco::DT_UINT8
+                        : bits <= 16 ? draco::DT_UINT16
+                                     : draco::DT_UINT32;
+}
+
+// Returns the size in bytes of one output value of an attribute.
+static size_t output_value_size(const AttributePlacement &placement) {
+  return static_cast<size_t>(placement.num_components) *
+         sizeof_data_type(placement.data_type);
+}
 
-  // Collect and sort attributes by unique_id
-  struct AttrEntry {
-    const draco::PointAttribute *attr = nullptr;
-    int unique_id = 0;
+// Returns the writer of the output format in `placement`, resolved once so
+// writes dispatch through it instead of on the format of every range.
+static WriteRangeFn output_writer(const AttributePlacement &placement) {
+  if (placement.normal_format != kNormalFloat32)
+    return normal_writer(placement.normal_format);
+  if (placement.dequantize)
+    return write_dequantized_range;
+  return attribute_writer(placement.data_type, placement.num_components);
+}
+
+// Index formats of DecodeOptions::index_format.
+constexpr uint32_t kIndexAuto = 0;
+constexpr uint32_t kIndexSmallest = 1;
+constexpr uint32_t kIndexU8 = 2;
+constexpr uint32_t kIndexU16 = 3;
+constexpr uint32_t kIndexU32 = 4;
+
+// Returns the size in bytes of the indices of a geometry with `num_points`
+// points in `format`, or 0 if a forced width cannot address every point. The
+// largest index is num_points - 1, so a width fits up to 2^bits points.
+static size_t index_size_for(uint32_t num_points, uint32_t format) {
+  const bool fits_u8 = num_points <= uint32_t{1} << 8;
+  const bool fits_u16 = num_points <= uint32_t{1} << 16;
+  switch (format) {
+  case kIndexAuto:
+    return fits_u16 ? sizeof(uint16_t) : sizeof(uint32_t);
+  case kIndexSmallest:
+    return fits_u8    ? sizeof(uint8_t)
+           : fits_u16 ? sizeof(uint16_t)
+                      : sizeof(uint32_t);
+  case kIndexU8:
+    return fits_u8 ? sizeof(uint8_t) : 0;
+  case kIndexU16:
+    return fits_u16 ? sizeof(uint16_t) : 0;
+  default:
+    return sizeof(uint32_t);
+  }
+}
+
+// Lays out `num_points` points and `num_faces` faces of a geometry whose
+// attributes are given in output order, as requested by `options`. Attributes
+// excluded by the filter of `options` are left out. Reuses the storage of
+// `layout`. Returns false if the options are invalid.
+static bool build_layout(uint32_t num_points, uint32_t num_faces,
+                         const AttributeList &all_attrs,
+                         const DecodeOptions &options, MeshLayout &layout) {
+  if (options.layout > kLayoutGrouped ||
+      !is_valid_alignment(options.alignment) ||
+      options.normal_format > kNormalSnorm8 ||
+      options.index_format > kIndexU32)
+    return false;
+
+  layout.num_points = num_points;
+  layout.num_faces = num_faces;
+  const size_t index_count = static_cast<size_t>(num_faces) * 3;
+  layout.index_size = index_size_for(num_points, options.index_format);
+  if (layout.index_size == 0)
+    return false;
+  layout.index_length = index_count * layout.index_size;
+  layout.attributes.clear();
+  for (const draco::PointAttribute *attr : all_attrs) {
+    if (is_attribute_selected(*attr, options))
+      layout.attributes.push_back(attr);
+  }
+  const AttributeList &attrs = layout.attributes;
+  const size_t count = attrs.size();
+  layout.placements.assign(count, AttributePlacement());
+  layout.blocks.clear();
+  for (size_t i = 0; i < count; ++i) {
+    AttributePlacement &placement = layout.placements[i];
+    set_output_format(*attrs[i], options, placement);
+    placement.write = output_writer(placement);
+  }
+
+  // Alignment of every attribute inside a vertex.
+  std::vector<size_t> alignments(count,
+                                 std::max<uint32_t>(options.alignment, 1));
+  for (const AttributeAlignment &entry : options.alignments) {
+    if (!is_valid_alignment(entry.alignment))
+      return false;
+    const size_t i = find_attribute(attrs, entry.unique_id);
+    if (i < count && entry.alignment > 0)
+      alignments[i] = entry.alignment;
+  }
+
+  // Assign every attribute a (block, position in block) key. Grouped layouts
+  // keep listed attributes in list order and give every unlisted attribute a
+  // planar block after the groups.
+  struct Slot {
+    uint64_t block;
+    size_t rank;
+    size_t attribute;
   };
+  std::vector<Slot> slots(count);
+  for (size_t i = 0; i < count; ++i) {
+    const uint64_t block = options.layout == kLayoutInterleaved ? 0 : i;
+    slots[i] = {block, i, i};
+  }
+  if (options.layout == kLayoutGrouped) {
+    std::vector<bool> listed(count, false);
+    for (size_t rank = 0; rank < options.groups.size(); ++rank) {
+      const AttributeGroupEntry &entry = options.groups[rank];
+      const size_t i = find_attribute(attrs, entry.unique_id);
+      if (i < count) {
+        slots[i] = {entry.group, rank, i};
+        listed[i] = true;
+      }
+    }
+    const uint64_t first_unlisted = uint64_t{1} << 32;
+    for (size_t i = 0; i < count; ++i) {
+      if (!listed[i])
+        slots[i] = {first_unlisted + i, 0, i};
+    }
+  }
+  std::sort(slots.begin(), slots.end(), [](const Slot &a, const Slot &b) {
+    return a.block != b.block ? a.block < b.block : a.rank < b.rank;
+  });
+
+  // Place the blocks after the index block.
+  size_t cursor = layout.index_length;
+  for (size_t first = 0; first < count;) {
+    size_t last = first;
+    size_t block_alignment = 1;
+    while (last < count && slots[last].block == slots[first].block) {
+      block_alignment =
+          std::max(block_alignment, alignments[slots[last].attribute]);
+      ++last;
+    }
 
-  std::vector<AttrEntry> attrs;
-  attrs.reserve(mesh->num_attributes());
+    VertexBlock block;
+    block.offset = align_up(cursor, block_alignment);
+    size_t vertex_size = 0;
+    size_t data_size = 0;
+    for (size_t k = first; k < last; ++k) {
+      const size_t i = slots[k].attribute;
+      const size_t value_size = output_value_size(layout.placements[i]);
+      vertex_size = align_up(vertex_size, alignments[i]);
+      layout.placements[i].offset = block.offset + vertex_size;
+      vertex_size += value_size;
+      data_size += value_size;
+      block.members.push_back(i);
+    }
+    block.stride = align_up(vertex_size, block_alignment);
+    block.has_padding = block.stride != data_size;
+    for (size_t i : block.members) {
+      layout.placements[i].stride = block.stride;
+    }
 
-  for (int i = 0; i < mesh->num_attributes(); ++i) {
-    const draco::PointAttribute *attr = mesh->attribute(i);
-    AttrEntry e;
-    e.attr = attr;
-    e.unique_id = attr->unique_id();
-    attrs.push_back(e);
+    cursor = block.offset + block.stride * num_points;
+    layout.blocks.push_back(std::move(block));
+    first = last;
   }
+  layout.buffer_size = cursor;
+  return true;
+}
 
-  std::sort(attrs.begin(), attrs.end(),
-            [](const AttrEntry &a, const AttrEntry &b) {
-              return a.unique_id < b.unique_id;
-            });
+// Fills `layout` with the default planar layout, one tightly packed block per
+// attribute.
+static void build_planar_layout(uint32_t num_points, uint32_t num_faces,
+                                const AttributeList &attrs,
+                                MeshLayout &layout) {
+  build_layout(num_points, num_faces, attrs, DecodeOptions{}, layout);
+}
 
-  // Calculate offsets and fill attribute info
-  uint32_t current_offset = config.index_length;
+// Fills `config` from `layout`.
+static void fill_config(const MeshLayout &layout, MeshConfig &config) {
+  // Basic info
+  config.vertex_count = layout.num_points;
+  config.index_count = layout.num_faces * 3;
+  config.index_length = static_cast<uint32_t>(layout.index_length);
+  config.index_data_type = layout.index_size == sizeof(uint8_t)    ? 1
+                           : layout.index_size == sizeof(uint16_t) ? 3
+                                                                   : 5;
 
-  for (auto &entry : attrs) {
-    const draco::PointAttribute *attr = entry.attr;
+  config.attributes.clear();
+  for (size_t i = 0; i < layout.attributes.size(); ++i) {
+    const draco::PointAttribute *attr = layout.attributes[i];
+    const AttributePlacement &placement = layout.placements[i];
     MeshAttribute mesh_attr;
 
-    mesh_attr.dim = attr->num_components();
+    mesh_attr.dim = placement.num_components;
     mesh_attr.unique_id = attr->unique_id();
+    mesh_attr.attribute_type = attribute_type_id(attr->attribute_type());
 
     // Convert Draco DataType to enum
-    switch (attr->data_type()) {
+    switch (placement.data_type) {
     case draco::DT_INT8:
       mesh_attr.data_type = 0;
       break;
@@ -159,167 +1013,723 @@ bool compute_mesh_config(const DracoMesh &draco_mesh, MeshConfig &config) {
       break;
     }
 
-    mesh_attr.offset = current_offset;
-    mesh_attr.length = mesh_attr.dim * config.vertex_count *
-                       sizeof_data_type(attr->data_type());
+    // The length spans from the first value to the end of the last one.
+    mesh_attr.offset = static_cast<uint32_t>(placement.offset);
+    mesh_attr.byte_stride = static_cast<uint32_t>(placement.stride);
+    mesh_attr.length =
+        layout.num_points == 0
+            ? 0
+            : static_cast<uint32_t>(placement.stride * (layout.num_points - 1) +
+                                    output_value_size(placement));
+
+    // Dequantization parameters of values kept quantized
+    mesh_attr.quantization_bits = 0;
+    mesh_attr.quantization_range = 0.0f;
+    mesh_attr.quantization_origin.fill(0.0f);
+    draco::AttributeQuantizationTransform transform;
+    if (placement.quantization_bits > 0 && transform.InitFromAttribute(*attr)) {
+      mesh_attr.quantization_bits = placement.quantization_bits;
+      mesh_attr.quantization_range = transform.range();
+      for (int c = 0; c < attr->num_components(); ++c) {
+        mesh_attr.quantization_origin[c] = transform.min_value(c);
+      }
+    }
 
     config.attributes.push_back(mesh_attr);
-    current_offset += mesh_attr.length;
   }
 
-  config.buffer_size = current_offset;
+  config.buffer_size = layout.buffer_size;
+}
+
+bool compute_mesh_config(DracoMesh &draco_mesh, const DecodeOptions &options,
+                         MeshConfig &config) {
+  const draco::Mesh *mesh = draco_mesh.mesh.get();
+  if (!mesh) {
+    return false;
+  }
+  if (draco_mesh.attributes.empty()) {
+    sort_attributes(*mesh, draco_mesh.attributes);
+  }
+  // Built aside so invalid options keep the current plan.
+  auto plan = std::make_unique<MeshLayout>();
+  if (!build_layout(mesh->num_points(), mesh->num_faces(),
+                    draco_mesh.attributes, options, *plan)) {
+    return false;
+  }
+  fill_config(*plan, config);
+  draco_mesh.plan = std::move(plan);
+  return true;
+}
+
+// Mesh decoder of type `Base` that stops once the attribute descriptors have
+// been read, before any attribute value is decoded.
+template <typename Base> class ProbeDecoder : public Base {
+public:
+  bool described = false;
+
+protected:
+  bool DecodeAllAttributes() override {
+    described = true;
+    return false;
+  }
+};
+
+// Decodes the connectivity and attribute descriptors of `data` into `mesh`
+// with a ProbeDecoder<Base>, without any attribute value.
+template <typename Base>
+static bool probe_mesh_into(rust::Slice<const uint8_t> data,
+                            draco::Mesh &mesh) {
+  draco::DecoderBuffer buffer;
+  buffer.Init(reinterpret_cast<const char *>(data.data()), data.size());
+  ProbeDecoder<Base> decoder;
+  // Fails by design once the attribute values are reached.
+  decoder.Decode(draco::DecoderOptions(), &buffer, &mesh);
+  return decoder.described;
+}
+
+// Decodes the connectivity and attribute descriptors of `data` with a
+// ProbeDecoder<Base> and fills `config` as compute_mesh_config would.
+template <typename Base>
+static bool probe_mesh_config(rust::Slice<const uint8_t> data,
+                              const DecodeOptions &options,
+                              MeshConfig &config) {
+  draco::Mesh mesh;
+  if (!probe_mesh_into<Base>(data, mesh))
+    return false;
+
+  MeshLayout layout;
+  if (!build_layout(mesh.num_points(), mesh.num_faces(),
+                    sorted_attributes(mesh), options, layout)) {
+    return false;
+  }
+  fill_config(layout, config);
+  return true;
+}
+
+bool probe_mesh(rust::Slice<const uint8_t> data, const DecodeOptions &options,
+                MeshProbe &probe) {
+  draco::DecoderBuffer buffer;
+  buffer.Init(reinterpret_cast<const char *>(data.data()), data.size());
+  draco::DracoHeader header;
+  if (!draco::PointCloudDecoder::DecodeHeader(&buffer, &header).ok() ||
+      header.encoder_type != draco::TRIANGULAR_MESH) {
+    return false;
+  }
+  probe.version_major = header.version_major;
+  probe.version_minor = header.version_minor;
+  probe.encoder_method = header.encoder_method;
+  probe.flags = header.flags;
+
+  switch (header.encoder_method) {
+  case draco::MESH_SEQUENTIAL_ENCODING:
+    return probe_mesh_config<draco::MeshSequentialDecoder>(data, options,
+                                                           probe.config);
+  case draco::MESH_EDGEBREAKER_ENCODING:
+    return probe_mesh_config<draco::MeshEdgebreakerDecoder>(data, options,
+                                                            probe.config);
+  default:
+    return false;
+  }
+}
+
+#ifdef DRACO_DECODER_PERF
+bool compute_mesh_config_with_stats(DracoMesh &mesh,
+                                    const DecodeOptions &options,
+                                    MeshConfig &config, DecodeStats &stats) {
+  const uint64_t allocations = allocation_count();
+  const Clock::time_point start = Clock::now();
+  const bool ok = compute_mesh_config(mesh, options, config);
+  stats.config_ns = elapsed_ns(start);
+  stats.allocations += allocation_count() - allocations;
+  return ok;
+}
+#endif
+
+// Writes points [begin, end) of every attribute in `block` into `out_ptr`,
+// the start of a buffer laid out by `layout`. If `attribute_ns` is set, the
+// write time of each attribute is added to its entry. Returns false if a data
+// type is unsupported.
+static bool write_block_range(const MeshLayout &layout,
+                              const VertexBlock &block, uint32_t begin,
+                              uint32_t end, uint8_t *out_ptr,
+                              uint64_t *attribute_ns = nullptr) {
+  if (block.has_padding) {
+    memset(out_ptr + block.offset + static_cast<size_t>(begin) * block.stride,
+           0, static_cast<size_t>(end - begin) * block.stride);
+  }
+  for (size_t i : block.members) {
+    const AttributePlacement &placement = layout.placements[i];
+    uint8_t *out =
+        out_ptr + placement.offset + static_cast<size_t>(begin) * block.stride;
+    const Clock::time_point start =
+        attribute_ns ? Clock::now() : Clock::time_point();
+    if (!placement.write ||
+        !placement.write(*layout.attributes[i], begin, end, out, block.stride))
+      return false;
+    if (attribute_ns)
+      attribute_ns[i] += elapsed_ns(start);
+  }
+  return true;
+}
+
+// Zeroes the gaps that block alignment leaves between the blocks of `layout`.
+static void zero_block_gaps(const MeshLayout &layout, uint8_t *out_ptr) {
+  size_t cursor = layout.index_length;
+  for (const VertexBlock &block : layout.blocks) {
+    memset(out_ptr + cursor, 0, block.offset - cursor);
+    cursor = block.offset + block.stride * layout.num_points;
+  }
+}
+
+// Writes every point of `block`, in slices of points if it interleaves
+// several attributes so every attribute of a slice lands in lines that are
+// still cached. Returns false if a data type is unsupported.
+static bool write_vertex_block(const MeshLayout &layout,
+                               const VertexBlock &block, uint8_t *out_ptr,
+                               uint64_t *attribute_ns = nullptr) {
+  constexpr uint32_t kPointsPerSlice = 1 << 12;
+
+  const uint32_t num_points = layout.num_points;
+  const uint32_t slice =
+      block.members.size() > 1 ? kPointsPerSlice : num_points;
+  for (uint32_t begin = 0; begin < num_points; begin += slice) {
+    const uint32_t end =
+        num_points - begin < slice ? num_points : begin + slice;
+    if (!write_block_range(layout, block, begin, end, out_ptr, attribute_ns))
+      return false;
+  }
   return true;
 }
 
+// Time spent in each write phase of write_mesh.
+struct WriteTimings {
+  uint64_t index_ns = 0;
+  // Parallel to MeshLayout::attributes
+  std::vector<uint64_t> attribute_ns;
+};
+
+// Writes the index block and the vertex blocks of `mesh` as described by
+// `layout`, recording the write phases in `timings` if it is set. Returns the
+// number of bytes written, or 0 on failure.
+static size_t write_mesh(const draco::Mesh &mesh, const MeshLayout &layout,
+                         uint8_t *out_ptr, size_t out_len,
+                         WriteTimings *timings = nullptr) {
+  if (layout.buffer_size > out_len)
+    return 0;
+
+  const Clock::time_point index_start =
+      timings ? Clock::now() : Clock::time_point();
+  write_index_range(mesh, layout.index_size, 0, layout.num_faces, out_ptr);
+  zero_block_gaps(layout, out_ptr);
+
+  uint64_t *attribute_ns = nullptr;
+  if (timings) {
+    timings->index_ns = elapsed_ns(index_start);
+    timings->attribute_ns.assign(layout.attributes.size(), 0);
+    attribute_ns = timings->attribute_ns.data();
+  }
+
+  for (const VertexBlock &block : layout.blocks) {
+    if (!write_vertex_block(layout, block, out_ptr, attribute_ns))
+      return 0;
+  }
+
+  return layout.buffer_size;
+}
+
 size_t decode_mesh_to_buffer(const DracoMesh &draco_mesh, uint8_t *out_ptr,
                              size_t out_len) {
+  if (!draco_mesh.mesh || !draco_mesh.plan) {
+    return 0;
+  }
+  return write_mesh(*draco_mesh.mesh, *draco_mesh.plan, out_ptr, out_len);
+}
+
+// Deletes `attr` from `mesh`, freeing its values and point mapping.
+static void delete_attribute(draco::Mesh &mesh,
+                             const draco::PointAttribute *attr) {
+  for (int i = 0; i < mesh.num_attributes(); ++i) {
+    if (mesh.attribute(i) == attr) {
+      mesh.DeleteAttribute(i);
+      return;
+    }
+  }
+}
+
+// Writes `mesh` as described by `layout` like write_mesh, freeing it on the
+// way.
+static size_t consume_mesh(std::unique_ptr<draco::Mesh> mesh,
+                           const MeshLayout &layout, uint8_t *out_ptr,
+                           size_t out_len) {
+  if (layout.buffer_size > out_len)
+    return 0;
+
+  // Vertex blocks first, each freeing its attributes once written. Draco
+  // cannot shrink the face array alone, so the indices go last and the whole
+  // mesh is freed after them.
+  zero_block_gaps(layout, out_ptr);
+  for (const VertexBlock &block : layout.blocks) {
+    if (!write_vertex_block(layout, block, out_ptr))
+      return 0;
+    for (size_t i : block.members) {
+      delete_attribute(*mesh, layout.attributes[i]);
+    }
+  }
+  write_index_range(*mesh, layout.index_size, 0, layout.num_faces, out_ptr);
+  return layout.buffer_size;
+}
+
+size_t consume_mesh_to_buffer(DracoMesh &draco_mesh, uint8_t *out_ptr,
+                              size_t out_len) {
+  if (!draco_mesh.mesh || !draco_mesh.plan) {
+    return 0;
+  }
+  // The mesh is gone after this call, whether the write succeeds or not.
+  draco_mesh.attributes.clear();
+  return consume_mesh(std::move(draco_mesh.mesh), *draco_mesh.plan, out_ptr,
+                      out_len);
+}
+
+#ifdef DRACO_DECODER_PERF
+size_t decode_mesh_to_buffer_with_stats(const DracoMesh &draco_mesh,
+                                        uint8_t *out_ptr, size_t out_len,
+                                        DecodeStats &stats) {
+  if (!draco_mesh.mesh || !draco_mesh.plan) {
+    return 0;
+  }
+  const MeshLayout &layout = *draco_mesh.plan;
+  const uint64_t allocations = allocation_count();
+  WriteTimings timings;
+  const size_t written =
+      write_mesh(*draco_mesh.mesh, layout, out_ptr, out_len, &timings);
+  stats.allocations += allocation_count() - allocations;
+  if (!written) {
+    return 0;
+  }
+
+  stats.index_write_ns = timings.index_ns;
+  stats.attribute_write_ns.clear();
+  for (size_t i = 0; i < layout.attributes.size(); ++i) {
+    AttributeWriteTime time;
+    time.unique_id = layout.attributes[i]->unique_id();
+    time.nanoseconds = timings.attribute_ns[i];
+    stats.attribute_write_ns.push_back(time);
+  }
+  stats.bytes_out = written;
+  return written;
+}
+#endif
+
+size_t decode_mesh_to_buffer_parallel(const DracoMesh &draco_mesh,
+                                      uint8_t *out_ptr, size_t out_len,
+                                      size_t num_threads) {
   const draco::Mesh *mesh = draco_mesh.mesh.get();
-  if (!mesh) {
+  if (!mesh || !draco_mesh.plan || draco_mesh.plan->buffer_size > out_len) {
     return 0;
   }
+  const MeshLayout &layout = *draco_mesh.plan;
 
-  uint8_t *out = out_ptr;
-  const size_t out_end = reinterpret_cast<size_t>(out_ptr) + out_len;
+  // Large blocks are split so that a single big attribute still spreads
+  // across workers.
+  constexpr uint32_t kFacesPerTask = 1 << 16;
+  constexpr uint32_t kPointsPerTask = 1 << 16;
 
-  // Helper function to write scalar
-  auto write_scalar = [&](const void *src, draco::DataType type) -> bool {
-    size_t size = sizeof_data_type(type);
-    if (reinterpret_cast<size_t>(out) + size > out_end)
-      return false;
-    memcpy(out, src, size);
-    out += size;
-    return true;
+  // A contiguous range of faces (block == nullptr) or points of one vertex
+  // block.
+  struct Task {
+    const VertexBlock *block = nullptr;
+    uint32_t begin = 0;
+    uint32_t end = 0;
   };
 
-  // Write indices
-  const int num_faces = mesh->num_faces();
-  bool use_u16 =
-      (num_faces * 3 <= static_cast<int>(std::numeric_limits<uint16_t>::max()));
-
-  if (use_u16) {
-    for (draco::FaceIndex i(0); i < num_faces; ++i) {
-      const auto &face = mesh->face(i);
-      for (int j = 0; j < 3; ++j) {
-        uint16_t val = static_cast<uint16_t>(face[j].value());
-        if (reinterpret_cast<size_t>(out) + sizeof(uint16_t) > out_end)
-          return 0;
-        *reinterpret_cast<uint16_t *>(out) = val;
-        out += sizeof(uint16_t);
-      }
+  // Every task writes a disjoint range of the buffer.
+  std::vector<Task> tasks;
+  const uint32_t num_faces = layout.num_faces;
+  for (uint32_t begin = 0; begin < num_faces; begin += kFacesPerTask) {
+    Task task;
+    task.begin = begin;
+    task.end = std::min(num_faces, begin + kFacesPerTask);
+    tasks.push_back(task);
+  }
+  const uint32_t num_points = layout.num_points;
+  for (const VertexBlock &block : layout.blocks) {
+    for (uint32_t begin = 0; begin < num_points; begin += kPointsPerTask) {
+      Task task;
+      task.block = &block;
+      task.begin = begin;
+      task.end = std::min(num_points, begin + kPointsPerTask);
+      tasks.push_back(task);
     }
-  } else {
-    for (draco::FaceIndex i(0); i < num_faces; ++i) {
-      const auto &face = mesh->face(i);
-      for (int j = 0; j < 3; ++j) {
-        uint32_t val = static_cast<uint32_t>(face[j].value());
-        if (reinterpret_cast<size_t>(out) + sizeof(uint32_t) > out_end)
-          return 0;
-        *reinterpret_cast<uint32_t *>(out) = val;
-        out += sizeof(uint32_t);
-      }
+  }
+
+  zero_block_gaps(layout, out_ptr);
+
+  std::atomic<bool> failed{false};
+  ThreadPool::shared().parallel_for(
+      tasks.size(), num_threads, [&](size_t i) {
+        const Task &task = tasks[i];
+        if (!task.block) {
+          write_index_range(*mesh, layout.index_size, task.begin, task.end,
+                            out_ptr + static_cast<size_t>(task.begin) * 3 *
+                                          layout.index_size);
+        } else if (!write_block_range(layout, *task.block, task.begin,
+                                      task.end, out_ptr)) {
+          failed.store(true, std::memory_order_relaxed);
+        }
+      });
+
+  return failed.load() ? 0 : layout.buffer_size;
+}
+
+// Keeps the lowest index that failed in a parallel batch loop, with `status`
+// its reason. Indices below it are always run, so the result does not depend
+// on scheduling.
+struct BatchFailure {
+  explicit BatchFailure(size_t count) : index(count) {}
+
+  // True if index `i` may be skipped because a lower one already failed.
+  bool skips(size_t i) const {
+    return i > index.load(std::memory_order_relaxed);
+  }
+
+  void record(size_t i, const DracoStatus &reason) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (i < index.load(std::memory_order_relaxed)) {
+      index.store(i, std::memory_order_relaxed);
+      status = reason;
     }
   }
 
-  // Sort and write attributes
-  struct AttrEntry {
-    const draco::PointAttribute *attr = nullptr;
-    int unique_id = 0;
-  };
+  std::atomic<size_t> index;
+  std::mutex mutex;
+  DracoStatus status{};
+};
 
-  std::vector<AttrEntry> attrs;
-  attrs.reserve(mesh->num_attributes());
+std::unique_ptr<DracoMeshBatch>
+create_mesh_batch(rust::Slice<const DracoBlob> blobs, size_t num_threads,
+                  rust::Vec<MeshConfig> &configs, size_t &failed_index,
+                  DracoStatus &status) {
+  const size_t count = blobs.size();
+  auto batch = std::make_unique<DracoMeshBatch>();
+  batch->meshes.resize(count);
+  batch->buffer_sizes.resize(count);
+  std::vector<MeshConfig> batch_configs(count);
 
-  for (int i = 0; i < mesh->num_attributes(); ++i) {
-    const draco::PointAttribute *attr = mesh->attribute(i);
-    AttrEntry e;
-    e.attr = attr;
-    e.unique_id = attr->unique_id();
-    attrs.push_back(e);
+  BatchFailure failure(count);
+  ThreadPool::shared().parallel_for(count, num_threads, [&](size_t i) {
+    if (failure.skips(i)) {
+      return;
+    }
+    draco::Decoder decoder;
+    DracoStatus mesh_status{};
+    std::unique_ptr<draco::Mesh> mesh = decode_mesh(
+        decoder, blobs[i].data.data(), blobs[i].data.size(), &mesh_status);
+    if (!mesh) {
+      failure.record(i, mesh_status);
+      return;
+    }
+    batch->meshes[i] = std::make_unique<DracoMesh>(std::move(mesh));
+    // An OK status tells the caller the layout failed, not Draco.
+    if (!compute_mesh_config(*batch->meshes[i], DecodeOptions{},
+                             batch_configs[i])) {
+      failure.record(i, DracoStatus{});
+      return;
+    }
+    batch->buffer_sizes[i] = batch_configs[i].buffer_size;
+  });
+
+  failed_index = failure.index.load();
+  if (failed_index < count) {
+    status = std::move(failure.status);
+    return nullptr;
   }
 
-  std::sort(attrs.begin(), attrs.end(),
-            [](const AttrEntry &a, const AttrEntry &b) {
-              return a.unique_id < b.unique_id;
-            });
+  configs.reserve(configs.size() + count);
+  for (auto &config : batch_configs) {
+    configs.emplace_back(std::move(config));
+  }
+  return batch;
+}
 
-  int num_points = mesh->num_points();
-
-  for (auto &entry : attrs) {
-    const draco::PointAttribute *attr = entry.attr;
-    int dim = attr->num_components();
-    draco::DataType type = attr->data_type();
-
-    for (draco::PointIndex j(0); j < num_points; ++j) {
-      switch (type) {
-      case draco::DT_INT8: {
-        int8_t v[4] = {};
-        attr->ConvertValue(attr->mapped_index(j), v);
-        for (int k = 0; k < dim; ++k)
-          if (!write_scalar(&v[k], type))
-            return 0;
-        break;
-      }
-      case draco::DT_UINT8: {
-        uint8_t v[4] = {};
-        attr->ConvertValue(attr->mapped_index(j), v);
-        for (int k = 0; k < dim; ++k)
-          if (!write_scalar(&v[k], type))
-            return 0;
-        break;
-      }
-      case draco::DT_INT16: {
-        int16_t v[4] = {};
-        attr->ConvertValue(attr->mapped_index(j), v);
-        for (int k = 0; k < dim; ++k)
-          if (!write_scalar(&v[k], type))
-            return 0;
-        break;
-      }
-      case draco::DT_UINT16: {
-        uint16_t v[4] = {};
-        attr->ConvertValue(attr->mapped_index(j), v);
-        for (int k = 0; k < dim; ++k)
-          if (!write_scalar(&v[k], type))
-            return 0;
-        break;
-      }
-      case draco::DT_INT32: {
-        int32_t v[4] = {};
-        attr->ConvertValue(attr->mapped_index(j), v);
-        for (int k = 0; k < dim; ++k)
-          if (!write_scalar(&v[k], type))
-            return 0;
-        break;
-      }
-      case draco::DT_UINT32: {
-        uint32_t v[4] = {};
-        attr->ConvertValue(attr->mapped_index(j), v);
-        for (int k = 0; k < dim; ++k)
-          if (!write_scalar(&v[k], type))
-            return 0;
-        break;
-      }
-      case draco::DT_FLOAT32: {
-        float v[4] = {};
-        attr->ConvertValue(attr->mapped_index(j), v);
-        for (int k = 0; k < dim; ++k)
-          if (!write_scalar(&v[k], type))
-            return 0;
-        break;
-      }
-      case draco::DT_FLOAT64: {
-        double v[4] = {};
-        attr->ConvertValue(attr->mapped_index(j), v);
-        for (int k = 0; k < dim; ++k)
-          if (!write_scalar(&v[k], type))
-            return 0;
-        break;
-      }
-      default:
-        return 0;
-      }
+bool decode_mesh_batch_to_buffer(const DracoMeshBatch &batch,
+                                 rust::Slice<const size_t> offsets,
+                                 uint8_t *out_ptr, size_t out_len,
+                                 size_t num_threads, size_t &failed_index) {
+  const size_t count = batch.meshes.size();
+  failed_index = 0;
+  if (offsets.size() != count) {
+    return false;
+  }
+  for (size_t i = 0; i < count; ++i) {
+    if (offsets[i] > out_len || batch.buffer_sizes[i] > out_len - offsets[i]) {
+      failed_index = i;
+      return false;
     }
   }
 
+  // Meshes in a batch are usually small, so each one is decoded by a single
+  // thread and the pool balances across meshes instead.
+  BatchFailure failure(count);
+  ThreadPool::shared().parallel_for(count, num_threads, [&](size_t i) {
+    const size_t size = batch.buffer_sizes[i];
+    if (decode_mesh_to_buffer(*batch.meshes[i], out_ptr + offsets[i], size) !=
+        size) {
+      failure.record(i, DracoStatus{});
+    }
+  });
+  failed_index = failure.index.load();
+  return failed_index == count;
+}
+
+std::unique_ptr<DecoderContext> create_decoder_context() {
+  return std::make_unique<DecoderContext>();
+}
+
+#ifndef DRACO_DECODER_HEAP_BUDGET
+// C++ heap held by a decoded mesh: its faces, attribute values and point to
+// value maps.
+static size_t mesh_heap_bytes(const draco::Mesh &mesh) {
+  size_t bytes =
+      static_cast<size_t>(mesh.num_faces()) * sizeof(draco::Mesh::Face);
+  for (int i = 0; i < mesh.num_attributes(); ++i) {
+    const draco::PointAttribute &attr = *mesh.attribute(i);
+    if (attr.buffer())
+      bytes += attr.buffer()->data_size();
+    bytes += attr.indices_map_size() * sizeof(draco::AttributeValueIndex);
+  }
+  return bytes;
+}
+#endif
+
+bool context_decode_mesh(DecoderContext &context,
+                         rust::Slice<const uint8_t> data, size_t memory_budget,
+                         MeshConfig &config, HeapUsage &usage,
+                         DracoStatus &status) {
+  // Release the previous mesh first so its attribute buffers are freed before
+  // the next decode allocates new ones.
+  context.mesh.reset();
+  context.attributes.clear();
+  usage.bytes = 0;
+  usage.over_budget = false;
+
+#ifdef DRACO_DECODER_HEAP_BUDGET
+  HeapBudget budget(memory_budget);
+#else
+  // Without the operator new hook the caller checks the budget once the mesh
+  // is decoded, against its heap bytes and the size of the output.
+  (void)memory_budget;
+#endif
+  try {
+    std::unique_ptr<draco::Mesh> mesh =
+        decode_mesh(*context.decoder, data.data(), data.size(), &status);
+    if (!mesh) {
+      return false;
+    }
+    context.mesh = std::make_unique<DracoMesh>(std::move(mesh));
+
+    const draco::Mesh &decoded = *context.mesh->mesh;
+    sort_attributes(decoded, context.attributes);
+    build_planar_layout(decoded.num_points(), decoded.num_faces(),
+                        context.attributes, *context.layout);
+  } catch (const std::bad_alloc &) {
+    context.mesh.reset();
+    context.attributes.clear();
+#ifdef DRACO_DECODER_HEAP_BUDGET
+    usage.over_budget = budget.exceeded();
+#endif
+    if (!usage.over_budget)
+      set_status(&status, draco::Status(draco::Status::DRACO_ERROR,
+                                        "out of memory"));
+    return false;
+  }
+#ifdef DRACO_DECODER_HEAP_BUDGET
+  usage.bytes = budget.used();
+#else
+  usage.bytes = mesh_heap_bytes(*context.mesh->mesh);
+#endif
+  fill_config(*context.layout, config);
+  return true;
+}
+
+size_t context_write_mesh(DecoderContext &context, uint8_t *out_ptr,
+                          size_t out_len) {
+  if (!context.mesh) {
+    return 0;
+  }
+  std::unique_ptr<draco::Mesh> mesh = std::move(context.mesh->mesh);
+  context.mesh.reset();
+  context.attributes.clear();
+  return consume_mesh(std::move(mesh), *context.layout, out_ptr, out_len);
+}
+
+std::unique_ptr<DracoPointCloud>
+create_point_cloud(rust::Slice<const uint8_t> data, DracoStatus &status) {
+  draco::DecoderBuffer buffer;
+  buffer.Init(reinterpret_cast<const char *>(data.data()), data.size());
+
+  draco::Decoder decoder;
+  auto status_or_geometry = decoder.DecodePointCloudFromBuffer(&buffer);
+  if (!status_or_geometry.ok()) {
+    set_status(&status, status_or_geometry.status());
+    return nullptr;
+  }
+
+  auto point_cloud =
+      std::make_unique<DracoPointCloud>(std::move(status_or_geometry).value());
+  sort_attributes(*point_cloud->pc, point_cloud->attributes);
+  return point_cloud;
+}
+
+uint32_t point_cloud_num_points(const DracoPointCloud &point_cloud) {
+  return point_cloud.pc ? point_cloud.pc->num_points() : 0;
+}
+
+bool compute_point_cloud_config(const DracoPointCloud &point_cloud,
+                                uint32_t num_points, MeshConfig &config) {
+  if (!point_cloud.pc || num_points > point_cloud.pc->num_points()) {
+    return false;
+  }
+  MeshLayout layout;
+  build_planar_layout(num_points, 0, point_cloud.attributes, layout);
+  fill_config(layout, config);
+  return true;
+}
+
+size_t decode_point_cloud_to_buffer(const DracoPointCloud &point_cloud,
+                                    uint32_t first_point, uint32_t num_points,
+                                    uint8_t *out_ptr, size_t out_len) {
+  const draco::PointCloud *pc = point_cloud.pc.get();
+  if (!pc || first_point > pc->num_points() ||
+      num_points > pc->num_points() - first_point) {
+    return 0;
+  }
+
+  uint8_t *out = out_ptr;
+  const uint8_t *out_end = out_ptr + out_len;
+  const uint32_t end = first_point + num_points;
+  for (const draco::PointAttribute *attr : point_cloud.attributes) {
+    const size_t value_size = attribute_value_size(*attr);
+    const size_t size = value_size * num_points;
+    if (size > static_cast<size_t>(out_end - out) ||
+        !write_attribute_range(*attr, attr->data_type(), first_point, end, out,
+                               value_size)) {
+      return 0;
+    }
+    out += size;
+  }
   return static_cast<size_t>(out - out_ptr);
-}
\ No newline at end of file
+}
+
+// Deepest grid of chunk_point_cloud, 2^7 cells per axis, so the cell counts
+// take 8 MiB.
+constexpr uint32_t kMaxChunkDepth = 7;
+
+// Spreads the low 10 bits of `v` to every third bit.
+static uint32_t spread_bits(uint32_t v) {
+  v &= 0x3ff;
+  v = (v | (v << 16)) & 0x030000ff;
+  v = (v | (v << 8)) & 0x0300f00f;
+  v = (v | (v << 4)) & 0x030c30c3;
+  v = (v | (v << 2)) & 0x09249249;
+  return v;
+}
+
+// Morton code of grid cell (x, y, z), x in the lowest bit.
+static uint32_t morton_code(uint32_t x, uint32_t y, uint32_t z) {
+  return spread_bits(x) | (spread_bits(y) << 1) | (spread_bits(z) << 2);
+}
+
+bool chunk_point_cloud(DracoPointCloud &point_cloud, uint32_t depth,
+                       rust::Vec<SpatialChunk> &chunks) {
+  draco::PointCloud *pc = point_cloud.pc.get();
+  if (!pc || depth > kMaxChunkDepth)
+    return false;
+  const draco::PointAttribute *position =
+      pc->GetNamedAttribute(draco::GeometryAttribute::POSITION);
+  if (!position || position->num_components() != 3)
+    return false;
+  const uint32_t num_points = pc->num_points();
+
+  // Convert the positions once; the binning and scatter passes reuse them.
+  std::vector<float> xyz(size_t(num_points) * 3);
+  float lo[3] = {INFINITY, INFINITY, INFINITY};
+  float hi[3] = {-INFINITY, -INFINITY, -INFINITY};
+  for (uint32_t i = 0; i < num_points; ++i) {
+    float *p = &xyz[size_t(i) * 3];
+    position->ConvertValue<float>(
+        position->mapped_index(draco::PointIndex(i)), 3, p);
+    for (int c = 0; c < 3; ++c) {
+      lo[c] = std::min(lo[c], p[c]);
+      hi[c] = std::max(hi[c], p[c]);
+    }
+  }
+
+  // Bin every point into its cell and count the points per cell. NaN
+  // coordinates fall into the first cell of their axis.
+  const uint32_t max_cell = (1u << depth) - 1;
+  float scale[3];
+  for (int c = 0; c < 3; ++c) {
+    const float extent = hi[c] - lo[c];
+    scale[c] = extent > 0 ? static_cast<float>(max_cell + 1) / extent : 0;
+  }
+  std::vector<uint32_t> cells(num_points);
+  std::vector<uint32_t> counts(size_t(1) << (3 * depth), 0);
+  for (uint32_t i = 0; i < num_points; ++i) {
+    const float *p = &xyz[size_t(i) * 3];
+    uint32_t q[3];
+    for (int c = 0; c < 3; ++c) {
+      const float t = (p[c] - lo[c]) * scale[c];
+      q[c] = t > 0 ? std::min(static_cast<uint32_t>(t), max_cell) : 0;
+    }
+    cells[i] = morton_code(q[0], q[1], q[2]);
+    ++counts[cells[i]];
+  }
+
+  // One chunk per non-empty cell, in Morton order. `counts` becomes the
+  // chunk index of every cell and `cursor` its next output point.
+  chunks.clear();
+  std::vector<uint32_t> cursor(counts.size());
+  uint32_t next = 0;
+  for (uint32_t cell = 0; cell < counts.size(); ++cell) {
+    cursor[cell] = next;
+    if (counts[cell] == 0)
+      continue;
+    SpatialChunk chunk{};
+    chunk.first_point = next;
+    chunk.num_points = counts[cell];
+    chunk.cell = cell;
+    chunk.min = {INFINITY, INFINITY, INFINITY};
+    chunk.max = {-INFINITY, -INFINITY, -INFINITY};
+    next += counts[cell];
+    counts[cell] = static_cast<uint32_t>(chunks.size());
+    chunks.push_back(chunk);
+  }
+
+  // Order the points by cell, keeping their relative order within a cell,
+  // and grow the bounds of every chunk on the way.
+  std::vector<draco::PointIndex> order(num_points);
+  for (uint32_t i = 0; i < num_points; ++i) {
+    order[cursor[cells[i]]++] = draco::PointIndex(i);
+    SpatialChunk &chunk = chunks[counts[cells[i]]];
+    const float *p = &xyz[size_t(i) * 3];
+    for (int c = 0; c < 3; ++c) {
+      chunk.min[c] = std::min(chunk.min[c], p[c]);
+      chunk.max[c] = std::max(chunk.max[c], p[c]);
+    }
+  }
+
+  // Renumber the points through the point to value mapping, as
+  // optimize_vertex_order does, so the next write gathers them in order.
+  std::vector<draco::AttributeValueIndex> values(num_points);
+  for (int a = 0; a < pc->num_attributes(); ++a) {
+    draco::PointAttribute &attr = *pc->attribute(a);
+    for (uint32_t i = 0; i < num_points; ++i) {
+      values[i] = attr.mapped_index(order[i]);
+    }
+    attr.SetExplicitMapping(num_points);
+    for (uint32_t i = 0; i < num_points; ++i) {
+      attr.SetPointMapEntry(draco::PointIndex(i), values[i]);
+    }
+  }
+  return true;
+}
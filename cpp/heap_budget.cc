@@ -0,0 +1,162 @@
+#include "heap_budget.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <new>
+
+#ifdef DRACO_DECODER_HEAP_BUDGET
+namespace {
+
+// Size header in front of every block, keeping the block max-aligned.
+constexpr size_t kHeaderSize = alignof(std::max_align_t);
+constexpr int64_t kUnlimited = std::numeric_limits<int64_t>::max();
+
+#ifdef DRACO_DECODER_PERF
+thread_local uint64_t allocation_counter = 0;
+#endif
+thread_local int64_t live_bytes = 0;
+// Limit on live_bytes of the innermost HeapBudget
+thread_local int64_t live_limit = kUnlimited;
+thread_local bool limit_exceeded = false;
+
+// Returns nullptr if the block would pass the budget or malloc fails.
+void *allocate(size_t size) {
+  if (live_limit != kUnlimited &&
+      (live_bytes > live_limit ||
+       size > static_cast<uint64_t>(live_limit - live_bytes))) {
+    limit_exceeded = true;
+    return nullptr;
+  }
+  if (size > std::numeric_limits<size_t>::max() - kHeaderSize)
+    return nullptr;
+  void *block = std::malloc(size + kHeaderSize);
+  if (!block)
+    return nullptr;
+  *static_cast<size_t *>(block) = size;
+#ifdef DRACO_DECODER_PERF
+  ++allocation_counter;
+#endif
+  live_bytes += static_cast<int64_t>(size);
+  return static_cast<char *>(block) + kHeaderSize;
+}
+
+void deallocate(void *ptr) noexcept {
+  if (!ptr)
+    return;
+  void *block = static_cast<char *>(ptr) - kHeaderSize;
+  live_bytes -= static_cast<int64_t>(*static_cast<size_t *>(block));
+  std::free(block);
+}
+
+void *allocate_or_throw(size_t size) {
+  for (;;) {
+    if (void *ptr = allocate(size))
+      return ptr;
+    // Running out of budget is final; a new handler may free real memory.
+    std::new_handler handler = std::get_new_handler();
+    if (limit_exceeded || !handler)
+      throw std::bad_alloc();
+    handler();
+  }
+}
+
+} // namespace
+
+void *operator new(std::size_t size) { return allocate_or_throw(size); }
+void *operator new[](std::size_t size) { return allocate_or_throw(size); }
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  try {
+    return allocate_or_throw(size);
+  } catch (...) {
+    return nullptr;
+  }
+}
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+  return ::operator new(size, std::nothrow);
+}
+
+void operator delete(void *ptr) noexcept { deallocate(ptr); }
+void operator delete[](void *ptr) noexcept { deallocate(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { deallocate(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { deallocate(ptr); }
+void operator delete(void *ptr, const std::nothrow_t &) noexcept {
+  deallocate(ptr);
+}
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept {
+  deallocate(ptr);
+}
+
+HeapBudget::HeapBudget(size_t budget)
+    : start_(live_bytes), saved_limit_(live_limit),
+      saved_exceeded_(limit_exceeded) {
+  limit_exceeded = false;
+  if (budget == 0)
+    return;
+  // Both are far from overflowing: live bytes are bounded by the address
+  // space, and the clamp keeps start_ + budget below kUnlimited.
+  const int64_t limit =
+      start_ + static_cast<int64_t>(std::min<uint64_t>(budget, kUnlimited / 4));
+  live_limit = std::min(live_limit, limit);
+}
+
+HeapBudget::~HeapBudget() {
+  live_limit = saved_limit_;
+  limit_exceeded = saved_exceeded_;
+}
+
+size_t HeapBudget::used() const {
+  return static_cast<size_t>(std::max<int64_t>(live_bytes - start_, 0));
+}
+
+bool HeapBudget::exceeded() const { return limit_exceeded; }
+
+#elif defined(DRACO_DECODER_PERF)
+namespace {
+
+thread_local uint64_t allocation_counter = 0;
+
+void *allocate_or_throw(size_t size) {
+  ++allocation_counter;
+  for (;;) {
+    if (void *ptr = std::malloc(size ? size : 1))
+      return ptr;
+    std::new_handler handler = std::get_new_handler();
+    if (!handler)
+      throw std::bad_alloc();
+    handler();
+  }
+}
+
+} // namespace
+
+void *operator new(std::size_t size) { return allocate_or_throw(size); }
+void *operator new[](std::size_t size) { return allocate_or_throw(size); }
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  try {
+    return allocate_or_throw(size);
+  } catch (...) {
+    return nullptr;
+  }
+}
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+  return ::operator new(size, std::nothrow);
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, const std::nothrow_t &) noexcept {
+  std::free(ptr);
+}
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept {
+  std::free(ptr);
+}
+#endif
+
+#ifdef DRACO_DECODER_PERF
+uint64_t allocation_count() { return allocation_counter; }
+#endif
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// heap_budget.cc replaces the global operator new and delete, for the whole
+// process, in two opt-in builds:
+//
+// - DRACO_DECODER_HEAP_BUDGET (the `heap-budget` feature): every block carries
+//   its size, so the bytes live on each thread are known and a decode can be
+//   held to a HeapBudget. Blocks from every C++ library in the process go
+//   through it, and it conflicts with any other replacement of operator new.
+// - DRACO_DECODER_PERF (the `perf` feature): operator new counts its calls for
+//   allocation_count(), forwarding to malloc and free.
+//
+// Other builds leave the C++ allocator alone.
+
+#ifdef DRACO_DECODER_PERF
+// Returns the number of operator new calls on this thread so far.
+uint64_t allocation_count();
+#endif
+
+#ifdef DRACO_DECODER_HEAP_BUDGET
+// Holds the operator new calls of this thread, while in scope, to `budget`
+// bytes allocated and not freed since construction; 0 is unlimited. An
+// allocation past the budget throws std::bad_alloc. Blocks freed on another
+// thread than they were allocated on are credited to that thread.
+class HeapBudget {
+public:
+  explicit HeapBudget(size_t budget);
+  ~HeapBudget();
+  HeapBudget(const HeapBudget &) = delete;
+  HeapBudget &operator=(const HeapBudget &) = delete;
+
+  // Bytes allocated since construction and not freed yet
+  size_t used() const;
+  // Whether an allocation failed for passing the budget
+  bool exceeded() const;
+
+private:
+  int64_t start_;
+  int64_t saved_limit_;
+  bool saved_exceeded_;
+};
+#endif
@@ -0,0 +1,130 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
+struct ThreadPool::Job {
+  const std::function<void(size_t)> *fn = nullptr;
+  size_t count = 0;
+  // Number of pool workers that may still join this job.
+  size_t helpers_left = 0;
+  // Number of pool workers currently running this job.
+  size_t active = 0;
+  std::atomic<size_t> next{0};
+  // First exception thrown by fn, rethrown by parallel_for.
+  std::mutex error_mutex;
+  std::exception_ptr error;
+};
+
+ThreadPool::ThreadPool(size_t num_workers) {
+  workers_.reserve(num_workers);
+  for (size_t i = 0; i < num_workers; ++i) {
+    workers_.emplace_back([this] { worker_loop(); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  work_cv_.notify_all();
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+}
+
+ThreadPool &ThreadPool::shared() {
+  static ThreadPool pool([] {
+    const unsigned hw = std::thread::hardware_concurrency();
+    return hw > 1 ? static_cast<size_t>(hw - 1) : size_t(1);
+  }());
+  return pool;
+}
+
+void ThreadPool::run_job(Job &job) {
+  for (size_t i = job.next.fetch_add(1); i < job.count;
+       i = job.next.fetch_add(1)) {
+    try {
+      (*job.fn)(i);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(job.error_mutex);
+      if (!job.error) {
+        job.error = std::current_exception();
+      }
+      // Leave the remaining indices unclaimed.
+      job.next.store(job.count);
+    }
+  }
+}
+
+void ThreadPool::worker_loop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (;;) {
+    work_cv_.wait(lock, [this] { return stop_ || !jobs_.empty(); });
+    if (stop_) {
+      return;
+    }
+
+    Job *job = jobs_.front();
+    if (--job->helpers_left == 0) {
+      jobs_.pop_front();
+    }
+    ++job->active;
+
+    lock.unlock();
+    run_job(*job);
+    lock.lock();
+
+    if (--job->active == 0) {
+      done_cv_.notify_all();
+    }
+  }
+}
+
+void ThreadPool::parallel_for(size_t count, size_t max_threads,
+                              const std::function<void(size_t)> &fn) {
+  if (count == 0) {
+    return;
+  }
+
+  size_t helpers = workers_.size();
+  if (max_threads != 0) {
+    helpers = std::min(max_threads - 1, helpers);
+  }
+  helpers = std::min(helpers, count - 1);
+
+  Job job;
+  job.fn = &fn;
+  job.count = count;
+  if (helpers > 0) {
+    job.helpers_left = helpers;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      jobs_.push_back(&job);
+    }
+    if (helpers == 1) {
+      work_cv_.notify_one();
+    } else {
+      work_cv_.notify_all();
+    }
+  }
+
+  run_job(job);
+
+  if (helpers > 0) {
+    // Every index is claimed at this point. Withdraw the job from the queue
+    // and wait for helpers that are still finishing their last index.
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto it = std::find(jobs_.begin(), jobs_.end(), &job);
+    if (it != jobs_.end()) {
+      jobs_.erase(it);
+    }
+    done_cv_.wait(lock, [&job] { return job.active == 0; });
+  }
+
+  if (job.error) {
+    std::rethrow_exception(job.error);
+  }
+}
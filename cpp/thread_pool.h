@@ -0,0 +1,47 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads shared by the parallel decode paths. Work is
+// submitted as index ranges; idle workers pull the next index from whichever
+// job still has unclaimed items, and the submitting thread always works on its
+// own job, so concurrent callers never wait on each other's work.
+class ThreadPool {
+public:
+  explicit ThreadPool(size_t num_workers);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  // Process-wide pool with one worker per hardware thread, minus the caller.
+  static ThreadPool &shared();
+
+  // Calls fn(i) for every i in [0, count) on at most `max_threads` threads,
+  // including the calling thread, and returns once every call has finished.
+  // `max_threads == 0` uses every worker of the pool. If a call throws, the
+  // indices not yet claimed are skipped and the first exception is rethrown
+  // once the other calls have finished.
+  void parallel_for(size_t count, size_t max_threads,
+                    const std::function<void(size_t)> &fn);
+
+  size_t num_workers() const { return workers_.size(); }
+
+private:
+  struct Job;
+
+  void worker_loop();
+  static void run_job(Job &job);
+
+  std::mutex mutex_;
+  std::condition_variable work_cv_;
+  std::condition_variable done_cv_;
+  std::deque<Job *> jobs_;
+  std::vector<std::thread> workers_;
+  bool stop_ = false;
+};
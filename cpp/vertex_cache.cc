@@ -0,0 +1,136 @@
+#include "vertex_cache.h"
+
+#include <cstring>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t kNoVertex = UINT32_MAX;
+
+// Triangles around every vertex, in compressed sparse row form.
+struct VertexTriangles {
+  std::vector<uint32_t> offsets;
+  std::vector<uint32_t> triangles;
+};
+
+VertexTriangles build_vertex_triangles(const uint32_t *indices,
+                                       size_t index_count,
+                                       uint32_t vertex_count) {
+  VertexTriangles adjacency;
+  adjacency.offsets.assign(static_cast<size_t>(vertex_count) + 1, 0);
+  for (size_t i = 0; i < index_count; ++i) {
+    ++adjacency.offsets[indices[i] + 1];
+  }
+  for (uint32_t v = 0; v < vertex_count; ++v) {
+    adjacency.offsets[v + 1] += adjacency.offsets[v];
+  }
+  adjacency.triangles.resize(index_count);
+  std::vector<uint32_t> cursor(adjacency.offsets.begin(),
+                               adjacency.offsets.end() - 1);
+  for (size_t i = 0; i < index_count; ++i) {
+    adjacency.triangles[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+  }
+  return adjacency;
+}
+
+} // namespace
+
+void optimize_vertex_cache(uint32_t *indices, size_t index_count,
+                           uint32_t vertex_count) {
+  const size_t triangle_count = index_count / 3;
+  if (triangle_count < 2 || vertex_count == 0)
+    return;
+
+  const VertexTriangles adjacency =
+      build_vertex_triangles(indices, index_count, vertex_count);
+  // Number of triangles not yet emitted around every vertex.
+  std::vector<uint32_t> live(vertex_count);
+  for (uint32_t v = 0; v < vertex_count; ++v) {
+    live[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+  }
+  // Time stamp at which every vertex last entered the cache. Starting the
+  // clock past the cache size keeps untouched vertices out of it.
+  std::vector<uint32_t> cache_time(vertex_count, 0);
+  uint32_t time = kVertexCacheSize + 1;
+  std::vector<bool> emitted(triangle_count, false);
+  // Recently used vertices, to restart from once a fan runs dry.
+  std::vector<uint32_t> dead_end;
+  dead_end.reserve(index_count);
+  std::vector<uint32_t> candidates;
+  candidates.reserve(64);
+
+  std::vector<uint32_t> output;
+  output.reserve(index_count);
+  uint32_t fanning = 0;
+  uint32_t next_unvisited = 0;
+  while (fanning != kNoVertex) {
+    // Emit every remaining triangle around the fanning vertex.
+    candidates.clear();
+    for (uint32_t k = adjacency.offsets[fanning];
+         k < adjacency.offsets[fanning + 1]; ++k) {
+      const uint32_t triangle = adjacency.triangles[k];
+      if (emitted[triangle])
+        continue;
+      emitted[triangle] = true;
+      for (size_t c = 0; c < 3; ++c) {
+        const uint32_t v = indices[triangle * 3 + c];
+        output.push_back(v);
+        dead_end.push_back(v);
+        candidates.push_back(v);
+        --live[v];
+        if (time - cache_time[v] > kVertexCacheSize) {
+          cache_time[v] = time++;
+        }
+      }
+    }
+
+    // Continue with the candidate that stays in the cache the longest while
+    // its remaining triangles are emitted.
+    uint32_t best = kNoVertex;
+    uint32_t best_priority = 0;
+    for (uint32_t v : candidates) {
+      if (live[v] == 0)
+        continue;
+      uint32_t priority = 0;
+      if (time - cache_time[v] + 2 * live[v] <= kVertexCacheSize)
+        priority = time - cache_time[v];
+      if (best == kNoVertex || priority > best_priority) {
+        best = v;
+        best_priority = priority;
+      }
+    }
+
+    // Otherwise restart from a recent vertex, then from any vertex with
+    // triangles left.
+    while (best == kNoVertex && !dead_end.empty()) {
+      const uint32_t v = dead_end.back();
+      dead_end.pop_back();
+      if (live[v] > 0)
+        best = v;
+    }
+    while (best == kNoVertex && next_unvisited < vertex_count) {
+      if (live[next_unvisited] > 0)
+        best = next_unvisited;
+      ++next_unvisited;
+    }
+    fanning = best;
+  }
+
+  memcpy(indices, output.data(), output.size() * sizeof(uint32_t));
+}
+
+void build_vertex_fetch_remap(const uint32_t *indices, size_t index_count,
+                              uint32_t vertex_count, uint32_t *remap) {
+  for (uint32_t v = 0; v < vertex_count; ++v) {
+    remap[v] = kNoVertex;
+  }
+  uint32_t next = 0;
+  for (size_t i = 0; i < index_count; ++i) {
+    if (remap[indices[i]] == kNoVertex)
+      remap[indices[i]] = next++;
+  }
+  for (uint32_t v = 0; v < vertex_count; ++v) {
+    if (remap[v] == kNoVertex)
+      remap[v] = next++;
+  }
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Number of entries of the post-transform vertex cache the triangle order is
+// optimized for. Small enough for every GPU in use, and the order degrades
+// gracefully on larger caches.
+constexpr uint32_t kVertexCacheSize = 16;
+
+// Reorders the triangles of the triangle list `indices` in place so that
+// consecutive triangles reuse recently transformed vertices, using the
+// Tipsify algorithm of Sander, Nehab and Barczak (2007). Runs in time linear
+// in `index_count`; every index must be below `vertex_count`.
+void optimize_vertex_cache(uint32_t *indices, size_t index_count,
+                           uint32_t vertex_count);
+
+// Fills `remap[old_vertex]` with new vertex numbers in the order in which
+// `indices` first references the vertices, so vertex fetches walk memory
+// forwards. Unreferenced vertices are numbered last, in their old order.
+void build_vertex_fetch_remap(const uint32_t *indices, size_t index_count,
+                              uint32_t vertex_count, uint32_t *remap);
@@ -7,29 +7,178 @@
 // Forward declarations - defined in ffi.rs.h
 struct MeshAttribute;
 struct MeshConfig;
+struct DracoBlob;
+struct DecodeOptions;
+struct DecodeStats;
+struct MeshProbe;
+struct HeapUsage;
+struct DracoStatus;
+struct SpatialChunk;
 
-// Forward declaration for draco::Mesh
+// Output layout of a decoded geometry - defined in decoder_api.cc
+struct MeshLayout;
+
+// Forward declarations for draco types
 namespace draco {
+class Decoder;
 class Mesh;
+class PointAttribute;
+class PointCloud;
 }
 
 // DracoMesh class - wraps draco::Mesh
 class DracoMesh {
 public:
   std::unique_ptr<draco::Mesh> mesh;
+  // Attributes in output order, sorted by unique_id
+  std::vector<const draco::PointAttribute *> attributes;
+  // Decode plan of the options last passed to compute_mesh_config
+  std::unique_ptr<MeshLayout> plan;
 
   explicit DracoMesh(std::unique_ptr<draco::Mesh> m);
   ~DracoMesh();
 };
 
+// DracoPointCloud class - wraps draco::PointCloud
+class DracoPointCloud {
+public:
+  std::unique_ptr<draco::PointCloud> pc;
+  // Attributes in output order, sorted by unique_id
+  std::vector<const draco::PointAttribute *> attributes;
+
+  explicit DracoPointCloud(std::unique_ptr<draco::PointCloud> p);
+  ~DracoPointCloud();
+};
+
+// DecoderContext class - decoder state and scratch storage kept between decodes
+class DecoderContext {
+public:
+  std::unique_ptr<draco::Decoder> decoder;
+  // Most recently decoded mesh, its attributes in output order and its layout
+  std::unique_ptr<DracoMesh> mesh;
+  std::vector<const draco::PointAttribute *> attributes;
+  std::unique_ptr<MeshLayout> layout;
+
+  DecoderContext();
+  ~DecoderContext();
+};
+
+// DracoMeshBatch class - owns every mesh decoded by one create_mesh_batch call
+class DracoMeshBatch {
+public:
+  std::vector<std::unique_ptr<DracoMesh>> meshes;
+  std::vector<size_t> buffer_sizes;
+};
+
+
+// Cache API - returns opaque type, or nullptr with the draco::Status of the
+// failure in `status`. Attributes excluded by the filter of `options` are
+// dropped right after the decode
+std::unique_ptr<DracoMesh> create_mesh(rust::Slice<const uint8_t> data,
+                                       const DecodeOptions &options,
+                                       DracoStatus &status);
+
+// Mesh Config from DracoMesh, laid out as requested by `options`. Stores the
+// decode plan in `mesh` for the writes below; invalid options keep the previous
+// plan.
+bool compute_mesh_config(DracoMesh &mesh, const DecodeOptions &options,
+                         MeshConfig &config);
+
+// Bit set of the attribute types, as in DecodeOptions::attribute_types, whose
+// output transform the filter of `options` skips at decode time. Only a pure
+// type filter skips any; an id filter only drops attributes after the decode.
+uint32_t skipped_transform_types(const DecodeOptions &options);
+
+// Header fields and config of an undecoded mesh, laid out as requested by
+// `options`. Decodes the connectivity and attribute descriptors but no
+// attribute values.
+bool probe_mesh(rust::Slice<const uint8_t> data, const DecodeOptions &options,
+                MeshProbe &probe);
+
+// Decode to pre-allocated buffer following the plan of compute_mesh_config
+size_t decode_mesh_to_buffer(const DracoMesh &mesh, uint8_t *out_ptr,
+                             size_t out_len);
+
+// Same as decode_mesh_to_buffer, but frees the values of every attribute as
+// soon as they are written and the whole mesh after the indices, so the
+// decoded mesh and the output are never held in full at once. `mesh` can
+// not be written again.
+size_t consume_mesh_to_buffer(DracoMesh &mesh, uint8_t *out_ptr,
+                              size_t out_len);
+
+#ifdef DRACO_DECODER_PERF
+// Stats variants (perf feature) - same as above, and record the phase timings,
+// byte counts and allocations of the call in `stats`
+std::unique_ptr<DracoMesh>
+create_mesh_with_stats(rust::Slice<const uint8_t> data, DecodeStats &stats);
+bool compute_mesh_config_with_stats(DracoMesh &mesh,
+                                    const DecodeOptions &options,
+                                    MeshConfig &config, DecodeStats &stats);
+size_t decode_mesh_to_buffer_with_stats(const DracoMesh &mesh,
+                                        uint8_t *out_ptr, size_t out_len,
+                                        DecodeStats &stats);
+#endif
+
+// Decode to pre-allocated buffer, writing the index block and vertex blocks
+// concurrently on up to `num_threads` threads (0 = all hardware threads)
+size_t decode_mesh_to_buffer_parallel(const DracoMesh &mesh,
+                                      uint8_t *out_ptr, size_t out_len,
+                                      size_t num_threads);
+
+// Batch API - decodes every blob on up to `num_threads` threads and appends one
+// config per mesh to `configs`. Returns nullptr if any blob fails to decode,
+// with `failed_index` the lowest such blob and `status` the Draco error, or an
+// OK status if its layout failed.
+std::unique_ptr<DracoMeshBatch>
+create_mesh_batch(rust::Slice<const DracoBlob> blobs, size_t num_threads,
+                  rust::Vec<MeshConfig> &configs, size_t &failed_index,
+                  DracoStatus &status);
+
+// Decode every mesh of the batch to out_ptr + offsets[i]. Returns false with
+// `failed_index` the lowest mesh that could not be written.
+bool decode_mesh_batch_to_buffer(const DracoMeshBatch &batch,
+                                 rust::Slice<const size_t> offsets,
+                                 uint8_t *out_ptr, size_t out_len,
+                                 size_t num_threads, size_t &failed_index);
+
+// Context API - reuses one decoder and its scratch storage across decodes
+std::unique_ptr<DecoderContext> create_decoder_context();
+
+// Decode `data` into the context and fill `config`, reusing its storage. The
+// C++ heap allocated by the decode is held to `memory_budget` bytes (0 =
+// unlimited) and reported in `usage`: tracked per allocation with
+// DRACO_DECODER_HEAP_BUDGET, else estimated before decoding and measured on
+// the decoded mesh. A Draco failure is reported in `status`.
+bool context_decode_mesh(DecoderContext &context,
+                         rust::Slice<const uint8_t> data, size_t memory_budget,
+                         MeshConfig &config, HeapUsage &usage,
+                         DracoStatus &status);
+
+// Write the mesh last decoded by the context to pre-allocated buffer, freeing
+// it on the way like consume_mesh_to_buffer
+size_t context_write_mesh(DecoderContext &context, uint8_t *out_ptr,
+                          size_t out_len);
+
+// Point cloud API - returns opaque type, or nullptr with the draco::Status of
+// the failure in `status`
+std::unique_ptr<DracoPointCloud>
+create_point_cloud(rust::Slice<const uint8_t> data, DracoStatus &status);
 
-rust::Vec<uint8_t> decode_point_cloud(rust::Slice<const uint8_t> data);
+uint32_t point_cloud_num_points(const DracoPointCloud &point_cloud);
 
-// Cache API - returns opaque type
-std::unique_ptr<DracoMesh> create_mesh(rust::Slice<const uint8_t> data);
+// Point cloud config for `num_points` points, in the same layout as meshes
+bool compute_point_cloud_config(const DracoPointCloud &point_cloud,
+                                uint32_t num_points, MeshConfig &config);
 
-// Mesh Config from DracoMesh
-bool compute_mesh_config(const DracoMesh &mesh, MeshConfig &config);
+// Decode points [first_point, first_point + num_points) of every attribute to
+// pre-allocated buffer
+size_t decode_point_cloud_to_buffer(const DracoPointCloud &point_cloud,
+                                    uint32_t first_point, uint32_t num_points,
+                                    uint8_t *out_ptr, size_t out_len);
 
-// Decode to pre-allocated buffer
-size_t decode_mesh_to_buffer(const DracoMesh &mesh, uint8_t *out_ptr, size_t out_len);
+// Sort the points into the cells of a 2^depth per axis grid over the bounds
+// of the positions and fill `chunks` with the range and bounds of every
+// non-empty cell, in Morton order. False without 3D positions or for a depth
+// above 7
+bool chunk_point_cloud(DracoPointCloud &point_cloud, uint32_t depth,
+                       rust::Vec<SpatialChunk> &chunks);
@@ -0,0 +1,194 @@
+// Spreads the decodes of src/wasm.rs over a pool of Web Workers.
+//
+// index.es.js is generated from third_party/draco_decoder_js by tools/build.js
+// and is not edited here. On import it creates one worker from a blob URL and
+// sends all of its decodes to that worker. The pool imports the bundle once,
+// with `Worker` shadowed in its module scope, so the import starts no worker
+// and only hands over the URL of the worker script. The pool reads the script
+// back, revokes the URL, and starts its own workers from that one script.
+// They speak the bundle's protocol:
+//
+// - request: { id, view, bufferLength, withConfig }, with `view` transferred
+// - reply: { id, success, decoded, config, error }, with `decoded` transferred
+//
+// The Draco module is compiled once, on the main thread, and every worker is
+// sent the compiled WebAssembly.Module ahead of its first decode. A prelude in
+// front of the worker script makes the Draco glue instantiate that module
+// instead of compiling its own embedded copy.
+
+const defaultSize = () =>
+  Math.max(1, (typeof navigator !== 'undefined' && navigator.hardwareConcurrency) || 4);
+
+// Declared ahead of the bundle, this class takes the place of the global
+// `Worker` for the bundle only.
+const CAPTURE_WORKER = `export let workerUrl;
+class Worker extends EventTarget {
+  constructor(url) {
+    super();
+    workerUrl ??= url;
+  }
+  postMessage() {}
+  terminate() {}
+}
+`;
+
+// Put ahead of the worker script, so every worker revokes its own blob URL
+// once it has loaded.
+const REVOKE_SELF = '(self.URL || self.webkitURL).revokeObjectURL(self.location.href);\n';
+
+// Runs in every worker ahead of the worker script. Once the pool has posted
+// { wasmModule }, WebAssembly.instantiate and instantiateStreaming instantiate
+// that module and ignore the source they are given. The message is taken
+// before the worker script's own handler sees it.
+function workerPrelude() {
+  let shared = null;
+  const { instantiate, instantiateStreaming } = WebAssembly;
+  const fromShared = (imports) =>
+    instantiate(shared, imports).then((instance) => ({ module: shared, instance }));
+  WebAssembly.instantiate = (source, imports) =>
+    shared && !(source instanceof WebAssembly.Module)
+      ? fromShared(imports)
+      : instantiate(source, imports);
+  WebAssembly.instantiateStreaming = (source, imports) =>
+    shared ? fromShared(imports) : instantiateStreaming(source, imports);
+  self.addEventListener('message', (event) => {
+    if (event.data && event.data.wasmModule) {
+      shared = event.data.wasmModule;
+      event.stopImmediatePropagation();
+    }
+  });
+}
+
+const PRELUDE = `(${workerPrelude})();\n`;
+
+// Compiles the Draco module from its bytes, streaming where supported. On
+// failure, resolves to null and every worker compiles its own copy.
+async function compile(wasm) {
+  try {
+    if (typeof WebAssembly.compileStreaming === 'function') {
+      const response = new Response(wasm, { headers: { 'Content-Type': 'application/wasm' } });
+      return await WebAssembly.compileStreaming(response).catch(() => WebAssembly.compile(wasm));
+    }
+    return await WebAssembly.compile(wasm);
+  } catch {
+    return null;
+  }
+}
+
+// Imports the bundle once and returns its worker script as a Blob.
+async function workerScript(bundle) {
+  const url = URL.createObjectURL(
+    new Blob([CAPTURE_WORKER, bundle], { type: 'text/javascript' }),
+  );
+  let workerUrl;
+  try {
+    ({ workerUrl } = await import(url));
+  } finally {
+    URL.revokeObjectURL(url);
+  }
+  if (!workerUrl) throw new Error('index.es.js did not create its worker');
+  try {
+    return await (await fetch(workerUrl)).blob();
+  } finally {
+    if (workerUrl.startsWith('blob:')) URL.revokeObjectURL(workerUrl);
+  }
+}
+
+// Creates a pool of up to `size` workers running the worker script of the
+// bundle `source`, with `wasm` the bytes of the Draco module embedded in it.
+// A decode goes to the worker with the fewest pending decodes. A worker is
+// added only while every existing one is busy, so a single decode starts a
+// single worker.
+export function createPool(source, wasm, size = defaultSize()) {
+  let setup = null;
+  const workers = [];
+  const requests = new Map();
+  let nextId = 0;
+
+  // Resolves to the worker script and the compiled module, or null for it.
+  function start() {
+    if (!setup) {
+      setup = Promise.all([workerScript(source), compile(wasm)]);
+      // Retry on the next decode rather than failing every later one.
+      setup.catch(() => {
+        setup = null;
+      });
+    }
+    return setup;
+  }
+
+  function settle({ id, success, decoded, config, error }) {
+    const request = requests.get(id);
+    if (!request) return;
+    requests.delete(id);
+    request.worker.pending--;
+    if (!success) request.reject(error);
+    else request.resolve(config ? { decoded, config } : decoded);
+  }
+
+  function add() {
+    const worker = { pending: 0 };
+    worker.thread = start().then(([script, module]) => {
+      const url = URL.createObjectURL(
+        new Blob([REVOKE_SELF, PRELUDE, script], { type: 'text/javascript' }),
+      );
+      const thread = new Worker(url);
+      thread.addEventListener('error', () => URL.revokeObjectURL(url));
+      thread.onmessage = (event) => settle(event.data);
+      if (module) thread.postMessage({ wasmModule: module });
+      return thread;
+    });
+    // A worker that failed to start is dropped so the next decode starts another.
+    worker.thread.catch(() => {
+      const index = workers.indexOf(worker);
+      if (index >= 0) workers.splice(index, 1);
+    });
+    workers.push(worker);
+    return worker;
+  }
+
+  function pick() {
+    let best = null;
+    for (const worker of workers) {
+      if (!best || worker.pending < best.pending) best = worker;
+    }
+    if (best && (best.pending === 0 || workers.length >= size)) return best;
+    return add();
+  }
+
+  function post(worker, view, message) {
+    worker.pending++;
+    return new Promise((resolve, reject) => {
+      const id = nextId++;
+      requests.set(id, { worker, resolve, reject });
+      worker.thread.then(
+        (thread) => thread.postMessage({ id, view, ...message }, [view.buffer]),
+        (error) => {
+          requests.delete(id);
+          worker.pending--;
+          reject(error);
+        },
+      );
+    });
+  }
+
+  // Compiles the Draco module and starts one worker, which instantiates it.
+  // Later workers start on demand and instantiate the same module. A worker
+  // instantiates the module before it looks at its input, so the empty buffer
+  // sent here is enough; it is then rejected as not a mesh.
+  async function warmUp() {
+    await start();
+    const worker = workers[0] || add();
+    await worker.thread;
+    await post(worker, new Uint8Array(0), { bufferLength: 0, withConfig: false }).catch(
+      () => {},
+    );
+  }
+
+  return {
+    decodeDracoMeshInWorker: (view, bufferLength) =>
+      post(pick(), view, { bufferLength, withConfig: false }),
+    decodeDracoMeshInWorkerWithConfig: (view) => post(pick(), view, { withConfig: true }),
+    warmUp,
+  };
+}
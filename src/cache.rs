@@ -0,0 +1,297 @@
+//! Content-addressed cache of decoded meshes (native only).
+
+use std::collections::HashMap;
+use std::hash::Hash;
+use std::sync::atomic::{AtomicU64, AtomicUsize, Ordering};
+use std::sync::{Arc, Mutex};
+
+use xxhash_rust::xxh3::Xxh3Default;
+
+use crate::{DecodeOptions, MeshDecodeResult};
+
+/// Counters of a [`DecodeCache`].
+#[derive(Clone, Copy, Debug, Default, PartialEq, Eq)]
+pub struct CacheStats {
+    /// Lookups answered from the cache
+    pub hits: u64,
+    /// Lookups that had to decode
+    pub misses: u64,
+    /// Entries dropped to make room for new ones
+    pub evictions: u64,
+    /// Entries currently cached
+    pub entries: usize,
+    /// Bytes of decoded data currently cached
+    pub bytes: usize,
+}
+
+struct Slot {
+    key: u128,
+    result: Arc<MeshDecodeResult>,
+    size: usize,
+    referenced: bool,
+}
+
+/// One lock's worth of entries, evicted in CLOCK order.
+#[derive(Default)]
+struct Shard {
+    index: HashMap<u128, usize>,
+    slots: Vec<Slot>,
+    hand: usize,
+    bytes: usize,
+}
+
+impl Shard {
+    fn get(&mut self, key: u128) -> Option<Arc<MeshDecodeResult>> {
+        let slot = &mut self.slots[*self.index.get(&key)?];
+        slot.referenced = true;
+        Some(slot.result.clone())
+    }
+
+    /// Inserts `result` and returns whether it did, keeping an entry that
+    /// another thread inserted first.
+    fn insert(&mut self, key: u128, result: &Arc<MeshDecodeResult>, size: usize) -> bool {
+        if self.index.contains_key(&key) {
+            return false;
+        }
+        self.index.insert(key, self.slots.len());
+        self.slots.push(Slot {
+            key,
+            result: result.clone(),
+            size,
+            referenced: false,
+        });
+        self.bytes += size;
+        true
+    }
+
+    /// Advances the clock hand past referenced entries, clearing their bit,
+    /// and evicts the first unreferenced one. Returns its size.
+    fn evict_one(&mut self) -> usize {
+        loop {
+            if self.hand >= self.slots.len() {
+                self.hand = 0;
+            }
+            let slot = &mut self.slots[self.hand];
+            if !slot.referenced {
+                break;
+            }
+            slot.referenced = false;
+            self.hand += 1;
+        }
+        let slot = self.slots.swap_remove(self.hand);
+        self.index.remove(&slot.key);
+        self.bytes -= slot.size;
+        if let Some(moved) = self.slots.get(self.hand) {
+            self.index.insert(moved.key, self.hand);
+        }
+        slot.size
+    }
+}
+
+/// A size-bounded cache of decode results, keyed by an xxh3 hash of the
+/// compressed data and the decode options.
+///
+/// Results are shared as `Arc`s, so a hit costs a hash of the input and no
+/// copy. The cache is split into shards with a lock each, picked by key, so
+/// concurrent lookups rarely contend. The capacity is shared by all shards:
+/// once it is used, an insert evicts in CLOCK order from its own shard, then
+/// from the following ones, so any result up to the whole capacity is cached.
+/// Two threads missing on the same data at once both decode it, and the first
+/// result is kept.
+///
+/// # Example
+///
+/// ```ignore
+/// use draco_decoder::DecodeCache;
+///
+/// let cache = DecodeCache::new(256 << 20);
+/// let result = cache.decode(data).unwrap();
+/// println!("{:?}", cache.stats());
+/// ```
+pub struct DecodeCache {
+    shards: Box<[Mutex<Shard>]>,
+    capacity: usize,
+    /// Bytes cached or reserved by an insert in progress, over all shards
+    bytes: AtomicUsize,
+    hits: AtomicU64,
+    misses: AtomicU64,
+    evictions: AtomicU64,
+}
+
+impl DecodeCache {
+    /// Creates a cache holding up to `capacity` bytes of decoded data, with
+    /// four shards per hardware thread.
+    pub fn new(capacity: usize) -> Self {
+        let threads = std::thread::available_parallelism().map_or(1, |n| n.get());
+        Self::with_shards(capacity, threads * 4)
+    }
+
+    /// Creates a cache holding up to `capacity` bytes of decoded data in
+    /// `shards` shards, rounded up to a power of two. A result larger than
+    /// `capacity` is returned but not cached.
+    pub fn with_shards(capacity: usize, shards: usize) -> Self {
+        let shards = shards.max(1).next_power_of_two();
+        Self {
+            shards: (0..shards).map(|_| Mutex::default()).collect(),
+            capacity,
+            bytes: AtomicUsize::new(0),
+            hits: AtomicU64::new(0),
+            misses: AtomicU64::new(0),
+            evictions: AtomicU64::new(0),
+        }
+    }
+
+    /// Returns the cached result for `data`, decoding and caching it like
+    /// [`crate::decode_mesh_with_config_sync`] on a miss.
+    ///
+    /// Returns `None` if decoding fails; failures are not cached.
+    pub fn decode(&self, data: &[u8]) -> Option<Arc<MeshDecodeResult>> {
+        self.get_or_decode(data, None, || {
+            crate::ffi::decode_mesh_with_config(data).ok()
+        })
+    }
+
+    /// Returns the cached result for `data` decoded with `options`, decoding
+    /// and caching it like [`crate::decode_mesh_with_options_sync`] on a miss.
+    pub fn decode_with_options(
+        &self,
+        data: &[u8],
+        options: &DecodeOptions,
+    ) -> Option<Arc<MeshDecodeResult>> {
+        self.get_or_decode(data, Some(options), || {
+            crate::ffi::decode_mesh_with_options(data, options).ok()
+        })
+    }
+
+    /// Returns the cached result for `data` decoded with `options`, if any,
+    /// without decoding on a miss. `None` stands for the default decode of
+    /// [`DecodeCache::decode`].
+    pub fn get(
+        &self,
+        data: &[u8],
+        options: Option<&DecodeOptions>,
+    ) -> Option<Arc<MeshDecodeResult>> {
+        let key = cache_key(data, options);
+        let result = self.shard(key).lock().unwrap().get(key);
+        let counter = if result.is_some() {
+            &self.hits
+        } else {
+            &self.misses
+        };
+        counter.fetch_add(1, Ordering::Relaxed);
+        result
+    }
+
+    /// Returns the hit, miss and eviction counters and the current size.
+    pub fn stats(&self) -> CacheStats {
+        let mut stats = CacheStats {
+            hits: self.hits.load(Ordering::Relaxed),
+            misses: self.misses.load(Ordering::Relaxed),
+            evictions: self.evictions.load(Ordering::Relaxed),
+            ..CacheStats::default()
+        };
+        for shard in &self.shards {
+            let shard = shard.lock().unwrap();
+            stats.entries += shard.slots.len();
+            stats.bytes += shard.bytes;
+        }
+        stats
+    }
+
+    /// Drops every cached entry. The counters are kept.
+    pub fn clear(&self) {
+        for shard in &self.shards {
+            let mut shard = shard.lock().unwrap();
+            self.bytes.fetch_sub(shard.bytes, Ordering::Relaxed);
+            *shard = Shard::default();
+        }
+    }
+
+    fn shard_index(&self, key: u128) -> usize {
+        // The low bits also pick the HashMap bucket, so shard by the high ones.
+        (key >> 64) as usize & (self.shards.len() - 1)
+    }
+
+    fn shard(&self, key: u128) -> &Mutex<Shard> {
+        &self.shards[self.shard_index(key)]
+    }
+
+    /// Caches `result` in the shard of `key` once enough bytes are evicted,
+    /// first from that shard, then from the following ones. Locks one shard
+    /// at a time. Gives up if the bytes cannot be reserved after evicting
+    /// every shard, e.g. while concurrent inserts hold the freed space.
+    fn insert(&self, key: u128, result: &Arc<MeshDecodeResult>) {
+        let size = result.data.len();
+        let home = self.shard_index(key);
+        if size > self.capacity || self.shards[home].lock().unwrap().index.contains_key(&key) {
+            return;
+        }
+
+        let mut reserved = self.try_reserve(size);
+        let mut evictions = 0;
+        for offset in 0..self.shards.len() {
+            if reserved {
+                break;
+            }
+            let mut shard = self.shards[(home + offset) & (self.shards.len() - 1)]
+                .lock()
+                .unwrap();
+            while !reserved && !shard.slots.is_empty() {
+                let freed = shard.evict_one();
+                self.bytes.fetch_sub(freed, Ordering::Relaxed);
+                evictions += 1;
+                reserved = self.try_reserve(size);
+            }
+        }
+        self.evictions.fetch_add(evictions, Ordering::Relaxed);
+
+        if reserved && !self.shards[home].lock().unwrap().insert(key, result, size) {
+            self.bytes.fetch_sub(size, Ordering::Relaxed);
+        }
+    }
+
+    /// Reserves `size` bytes if they fit in the capacity next to the bytes
+    /// cached and reserved by other inserts. The check and the update are one
+    /// atomic step, so concurrent inserts never reserve past the capacity.
+    fn try_reserve(&self, size: usize) -> bool {
+        self.bytes
+            .fetch_update(Ordering::Relaxed, Ordering::Relaxed, |bytes| {
+                bytes
+                    .checked_add(size)
+                    .filter(|&total| total <= self.capacity)
+            })
+            .is_ok()
+    }
+
+    /// Returns the bytes cached or reserved by an insert in progress.
+    #[cfg(test)]
+    pub(crate) fn reserved_bytes(&self) -> usize {
+        self.bytes.load(Ordering::Relaxed)
+    }
+
+    pub(crate) fn get_or_decode(
+        &self,
+        data: &[u8],
+        options: Option<&DecodeOptions>,
+        decode: impl FnOnce() -> Option<MeshDecodeResult>,
+    ) -> Option<Arc<MeshDecodeResult>> {
+        let key = cache_key(data, options);
+        if let Some(result) = self.shard(key).lock().unwrap().get(key) {
+            self.hits.fetch_add(1, Ordering::Relaxed);
+            return Some(result);
+        }
+        self.misses.fetch_add(1, Ordering::Relaxed);
+
+        // Decode without holding the lock.
+        let result = Arc::new(decode()?);
+        self.insert(key, &result);
+        Some(result)
+    }
+}
+
+fn cache_key(data: &[u8], options: Option<&DecodeOptions>) -> u128 {
+    let mut hasher = Xxh3Default::new();
+    hasher.update(data);
+    options.hash(&mut hasher);
+    hasher.digest128()
+}
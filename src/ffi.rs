@@ -1,3 +1,7 @@
+use std::fmt;
+use std::mem::MaybeUninit;
+use std::pin::Pin;
+
 #[cxx::bridge]
 mod cpp {
     struct MeshAttribute {
@@ -5,97 +9,1371 @@ mod cpp {
         data_type: u32,
         offset: u32,
         length: u32,
+        byte_stride: u32,
         unique_id: u32,
+        attribute_type: u32,
+        /// 0 unless the values were kept quantized
+        quantization_bits: u32,
+        quantization_range: f32,
+        quantization_origin: [f32; 4],
     }
 
     struct MeshConfig {
         vertex_count: u32,
         index_count: u32,
         index_length: u32,
+        /// Data type id of the indices, as in `MeshAttribute::data_type`
+        index_data_type: u32,
         buffer_size: usize,
         attributes: Vec<MeshAttribute>,
     }
 
+    /// Header fields and config of an undecoded mesh.
+    struct MeshProbe {
+        version_major: u8,
+        version_minor: u8,
+        /// 0 = sequential, 1 = edgebreaker
+        encoder_method: u8,
+        flags: u16,
+        config: MeshConfig,
+    }
+
+    struct DracoBlob<'a> {
+        data: &'a [u8],
+    }
+
+    struct AttributeGroupEntry {
+        unique_id: u32,
+        group: u32,
+    }
+
+    struct AttributeAlignment {
+        unique_id: u32,
+        alignment: u32,
+    }
+
+    /// Output layout request, see `crate::DecodeOptions`.
+    struct DecodeOptions {
+        /// 0 = planar, 1 = interleaved, 2 = grouped
+        layout: u32,
+        alignment: u32,
+        groups: Vec<AttributeGroupEntry>,
+        alignments: Vec<AttributeAlignment>,
+        /// Bit set of selected attribute type ids, bit 5 for unknown types
+        attribute_types: u32,
+        attribute_ids: Vec<u32>,
+        keep_quantized: bool,
+        /// 0 = float32, 1 = oct16, 2 = oct8, 3 = snorm16, 4 = snorm8
+        normal_format: u32,
+        /// 0 = auto, 1 = smallest, 2 = u8, 3 = u16, 4 = u32
+        index_format: u32,
+        optimize_vertex_cache: bool,
+    }
+
+    /// Code and message of a failed `draco::Status`.
+    struct DracoStatus {
+        code: i32,
+        message: String,
+    }
+
+    /// Range and bounds of one cell of a spatially chunked point cloud.
+    struct SpatialChunk {
+        first_point: u32,
+        num_points: u32,
+        /// Morton code of the grid cell
+        cell: u32,
+        min: [f32; 3],
+        max: [f32; 3],
+    }
+
+    /// C++ heap use of a context decode.
+    struct HeapUsage {
+        /// Bytes held by the decoded mesh and its layout
+        bytes: usize,
+        /// The decode failed because it would have passed its memory budget
+        over_budget: bool,
+    }
+
+    #[cfg(feature = "perf")]
+    struct AttributeWriteTime {
+        unique_id: u32,
+        nanoseconds: u64,
+    }
+
+    /// Phase timings of one decode, see `crate::DecodeStats`.
+    #[cfg(feature = "perf")]
+    struct DecodeStats {
+        parse_ns: u64,
+        config_ns: u64,
+        index_write_ns: u64,
+        attribute_write_ns: Vec<AttributeWriteTime>,
+        bytes_in: usize,
+        bytes_out: usize,
+        allocations: u64,
+    }
+
     unsafe extern "C++" {
         include!("decoder_api.h");
 
         type DracoMesh;
+        type DracoMeshBatch;
+        type DecoderContext;
+        type DracoPointCloud;
 
-        pub fn decode_point_cloud(data: &[u8]) -> Vec<u8>;
+        pub fn create_mesh(
+            data: &[u8],
+            options: &DecodeOptions,
+            status: &mut DracoStatus,
+        ) -> UniquePtr<DracoMesh>;
 
-        pub fn create_mesh(data: &[u8]) -> UniquePtr<DracoMesh>;
+        pub fn compute_mesh_config(
+            mesh: Pin<&mut DracoMesh>,
+            options: &DecodeOptions,
+            config: &mut MeshConfig,
+        ) -> bool;
 
-        pub fn compute_mesh_config(mesh: &DracoMesh, config: &mut MeshConfig) -> bool;
+        pub fn skipped_transform_types(options: &DecodeOptions) -> u32;
+
+        pub fn probe_mesh(data: &[u8], options: &DecodeOptions, probe: &mut MeshProbe) -> bool;
 
         pub unsafe fn decode_mesh_to_buffer(
             mesh: &DracoMesh,
             out_ptr: *mut u8,
             out_len: usize,
         ) -> usize;
+
+        pub unsafe fn consume_mesh_to_buffer(
+            mesh: Pin<&mut DracoMesh>,
+            out_ptr: *mut u8,
+            out_len: usize,
+        ) -> usize;
+
+        #[cfg(feature = "perf")]
+        pub fn create_mesh_with_stats(data: &[u8], stats: &mut DecodeStats)
+        -> UniquePtr<DracoMesh>;
+
+        #[cfg(feature = "perf")]
+        pub fn compute_mesh_config_with_stats(
+            mesh: Pin<&mut DracoMesh>,
+            options: &DecodeOptions,
+            config: &mut MeshConfig,
+            stats: &mut DecodeStats,
+        ) -> bool;
+
+        #[cfg(feature = "perf")]
+        pub unsafe fn decode_mesh_to_buffer_with_stats(
+            mesh: &DracoMesh,
+            out_ptr: *mut u8,
+            out_len: usize,
+            stats: &mut DecodeStats,
+        ) -> usize;
+
+        pub unsafe fn decode_mesh_to_buffer_parallel(
+            mesh: &DracoMesh,
+            out_ptr: *mut u8,
+            out_len: usize,
+            num_threads: usize,
+        ) -> usize;
+
+        pub fn create_mesh_batch<'a>(
+            blobs: &[DracoBlob<'a>],
+            num_threads: usize,
+            configs: &mut Vec<MeshConfig>,
+            failed_index: &mut usize,
+            status: &mut DracoStatus,
+        ) -> UniquePtr<DracoMeshBatch>;
+
+        pub unsafe fn decode_mesh_batch_to_buffer(
+            batch: &DracoMeshBatch,
+            offsets: &[usize],
+            out_ptr: *mut u8,
+            out_len: usize,
+            num_threads: usize,
+            failed_index: &mut usize,
+        ) -> bool;
+
+        pub fn create_decoder_context() -> UniquePtr<DecoderContext>;
+
+        pub fn context_decode_mesh(
+            context: Pin<&mut DecoderContext>,
+            data: &[u8],
+            memory_budget: usize,
+            config: &mut MeshConfig,
+            usage: &mut HeapUsage,
+            status: &mut DracoStatus,
+        ) -> bool;
+
+        pub unsafe fn context_write_mesh(
+            context: Pin<&mut DecoderContext>,
+            out_ptr: *mut u8,
+            out_len: usize,
+        ) -> usize;
+
+        pub fn create_point_cloud(
+            data: &[u8],
+            status: &mut DracoStatus,
+        ) -> UniquePtr<DracoPointCloud>;
+
+        pub fn point_cloud_num_points(point_cloud: &DracoPointCloud) -> u32;
+
+        pub fn compute_point_cloud_config(
+            point_cloud: &DracoPointCloud,
+            num_points: u32,
+            config: &mut MeshConfig,
+        ) -> bool;
+
+        pub unsafe fn decode_point_cloud_to_buffer(
+            point_cloud: &DracoPointCloud,
+            first_point: u32,
+            num_points: u32,
+            out_ptr: *mut u8,
+            out_len: usize,
+        ) -> usize;
+
+        pub fn chunk_point_cloud(
+            point_cloud: Pin<&mut DracoPointCloud>,
+            depth: u32,
+            chunks: &mut Vec<SpatialChunk>,
+        ) -> bool;
     }
 }
 
+// A context is only ever used through `&mut`, from one thread at a time.
+unsafe impl Send for cpp::DecoderContext {}
+// Decoded meshes and point clouds are never modified after creation, except
+// for the decode plan of a mesh, its consumption by the final write and the
+// spatial reordering of a point cloud, which only happen through
+// `Pin<&mut _>`.
+unsafe impl Send for cpp::DracoMesh {}
+unsafe impl Sync for cpp::DracoMesh {}
+unsafe impl Send for cpp::DracoPointCloud {}
+unsafe impl Sync for cpp::DracoPointCloud {}
+
+/// Alignment of every mesh start in a batch buffer, so 32-bit index and
+/// attribute blocks of each mesh stay naturally aligned.
+const BATCH_MESH_ALIGNMENT: usize = 4;
+
+/// Draco header flag set when the file carries metadata.
+const METADATA_FLAG_MASK: u16 = 0x8000;
+
+/// Decodes only the POSITION values of a point cloud.
 #[allow(dead_code)]
-pub fn decode_point_cloud_native(data: &[u8]) -> Vec<u8> {
-    cpp::decode_point_cloud(data)
+pub fn decode_point_cloud_native(data: &[u8]) -> Result<Vec<u8>, DecodeError> {
+    let result = DracoPointCloud::new(data)?.decode()?;
+    Ok(result
+        .config
+        .attributes()
+        .iter()
+        .find(|attr| attr.attribute_type() == crate::AttributeType::Position)
+        .map(|attr| {
+            let start = attr.offset() as usize;
+            result.data[start..start + attr.lenght() as usize].to_vec()
+        })
+        .unwrap_or_default())
 }
 
-fn convert_config(cpp_config: cpp::MeshConfig) -> crate::DracoDecodeConfig {
-    let mut config = crate::DracoDecodeConfig::new(
+fn convert_data_type(data_type: u32) -> crate::AttributeDataType {
+    match data_type {
+        0 => crate::AttributeDataType::Int8,
+        1 => crate::AttributeDataType::UInt8,
+        2 => crate::AttributeDataType::Int16,
+        3 => crate::AttributeDataType::UInt16,
+        4 => crate::AttributeDataType::Int32,
+        5 => crate::AttributeDataType::UInt32,
+        6 => crate::AttributeDataType::Float32,
+        _ => crate::AttributeDataType::UInt8,
+    }
+}
+
+fn convert_attribute_type(attribute_type: u32) -> crate::AttributeType {
+    match attribute_type {
+        0 => crate::AttributeType::Position,
+        1 => crate::AttributeType::Normal,
+        2 => crate::AttributeType::Color,
+        3 => crate::AttributeType::TexCoord,
+        4 => crate::AttributeType::Generic,
+        _ => crate::AttributeType::Unknown,
+    }
+}
+
+fn attribute_type_id(attribute_type: crate::AttributeType) -> u32 {
+    match attribute_type {
+        crate::AttributeType::Position => 0,
+        crate::AttributeType::Normal => 1,
+        crate::AttributeType::Color => 2,
+        crate::AttributeType::TexCoord => 3,
+        crate::AttributeType::Generic => 4,
+        crate::AttributeType::Unknown => 5,
+    }
+}
+
+fn fill_config(config: &mut crate::DracoDecodeConfig, cpp_config: &cpp::MeshConfig) {
+    config.reset(
         cpp_config.vertex_count,
         cpp_config.index_count,
         cpp_config.buffer_size,
     );
+    config.set_index_data_type(convert_data_type(cpp_config.index_data_type));
 
-    for attr in cpp_config.attributes {
-        let data_type = match attr.data_type {
-            0 => crate::AttributeDataType::Int8,
-            1 => crate::AttributeDataType::UInt8,
-            2 => crate::AttributeDataType::Int16,
-            3 => crate::AttributeDataType::UInt16,
-            4 => crate::AttributeDataType::Int32,
-            5 => crate::AttributeDataType::UInt32,
-            6 => crate::AttributeDataType::Float32,
-            _ => crate::AttributeDataType::UInt8,
-        };
-        config.add_attribute(attr.dim, data_type, attr.offset, attr.length);
+    for attr in &cpp_config.attributes {
+        config.add_attribute(crate::MeshAttribute {
+            dim: attr.dim,
+            data_type: convert_data_type(attr.data_type),
+            offset: attr.offset,
+            lenght: attr.length,
+            byte_stride: attr.byte_stride,
+            attribute_type: convert_attribute_type(attr.attribute_type),
+            unique_id: attr.unique_id,
+            quantization: (attr.quantization_bits > 0).then_some(crate::QuantizationInfo {
+                bits: attr.quantization_bits,
+                range: attr.quantization_range,
+                origin: attr.quantization_origin,
+                dim: attr.dim.min(crate::utils::MAX_QUANTIZED_COMPONENTS as u32),
+            }),
+        });
+    }
+}
+
+fn convert_options(options: &crate::DecodeOptions) -> cpp::DecodeOptions {
+    let (layout, groups) = match options.layout() {
+        crate::VertexLayout::Planar => (0, Vec::new()),
+        crate::VertexLayout::Interleaved => (1, Vec::new()),
+        crate::VertexLayout::Grouped(groups) => {
+            let entries = groups
+                .iter()
+                .enumerate()
+                .flat_map(|(group, ids)| {
+                    ids.iter().map(move |&unique_id| cpp::AttributeGroupEntry {
+                        unique_id,
+                        group: group as u32,
+                    })
+                })
+                .collect();
+            (2, entries)
+        }
+    };
+    cpp::DecodeOptions {
+        layout,
+        alignment: options.alignment(),
+        groups,
+        alignments: options
+            .attribute_alignments()
+            .iter()
+            .map(|&(unique_id, alignment)| cpp::AttributeAlignment {
+                unique_id,
+                alignment,
+            })
+            .collect(),
+        attribute_types: options
+            .attribute_types()
+            .iter()
+            .fold(0, |bits, &attribute_type| {
+                bits | 1 << attribute_type_id(attribute_type)
+            }),
+        attribute_ids: options.attribute_ids().to_vec(),
+        keep_quantized: options.keep_quantized(),
+        normal_format: match options.normal_format() {
+            crate::NormalFormat::Float32 => 0,
+            crate::NormalFormat::Oct16 => 1,
+            crate::NormalFormat::Oct8 => 2,
+            crate::NormalFormat::Snorm16 => 3,
+            crate::NormalFormat::Snorm8 => 4,
+        },
+        index_format: match options.index_format() {
+            crate::IndexFormat::Auto => 0,
+            crate::IndexFormat::Smallest => 1,
+            crate::IndexFormat::U8 => 2,
+            crate::IndexFormat::U16 => 3,
+            crate::IndexFormat::U32 => 4,
+        },
+        optimize_vertex_cache: options.optimize_vertex_cache(),
     }
+}
 
+fn planar_options() -> cpp::DecodeOptions {
+    convert_options(&crate::DecodeOptions::new())
+}
+
+fn convert_config(cpp_config: cpp::MeshConfig) -> crate::DracoDecodeConfig {
+    let mut config = crate::DracoDecodeConfig::new(0, 0, 0);
+    fill_config(&mut config, &cpp_config);
     config
 }
 
-pub fn decode_mesh_with_config(data: &[u8]) -> Option<crate::MeshDecodeResult> {
-    let mesh = cpp::create_mesh(data);
-    if mesh.is_null() {
-        panic!("Failed to create mesh from data");
+fn empty_status() -> cpp::DracoStatus {
+    cpp::DracoStatus {
+        code: 0,
+        message: String::new(),
     }
+}
 
-    let mut cpp_config = cpp::MeshConfig {
+fn empty_config() -> cpp::MeshConfig {
+    cpp::MeshConfig {
         vertex_count: 0,
         index_count: 0,
         index_length: 0,
+        index_data_type: 0,
         buffer_size: 0,
         attributes: Vec::new(),
+    }
+}
+
+/// Clears `buffer`, reserves `size` bytes and lets `write` fill the
+/// uninitialized spare capacity, so the decoded bytes are written exactly once
+/// instead of after a zeroing pass. `write` receives the output pointer and
+/// length and returns how many leading bytes it initialized; that becomes the
+/// length of `buffer`.
+fn write_uninit(
+    buffer: &mut Vec<u8>,
+    size: usize,
+    write: impl FnOnce(*mut u8, usize) -> usize,
+) -> usize {
+    buffer.clear();
+    buffer.reserve(size);
+    let written = write(buffer.spare_capacity_mut().as_mut_ptr().cast(), size);
+    assert!(written <= size, "decoder wrote past the output buffer");
+    // SAFETY: `write` initialized the first `written` bytes of the spare
+    // capacity, which holds at least `size` bytes.
+    unsafe { buffer.set_len(written) };
+    written
+}
+
+pub fn decode_mesh_with_config(data: &[u8]) -> Result<crate::MeshDecodeResult, DecodeError> {
+    // The mesh is dropped right after, so free it while writing.
+    decode_mesh(data, &planar_options(), |mesh, out_ptr, out_len| unsafe {
+        cpp::consume_mesh_to_buffer(mesh, out_ptr, out_len)
+    })
+}
+
+pub fn decode_mesh_with_config_parallel(
+    data: &[u8],
+    num_threads: usize,
+) -> Result<crate::MeshDecodeResult, DecodeError> {
+    decode_mesh(data, &planar_options(), |mesh, out_ptr, out_len| unsafe {
+        cpp::decode_mesh_to_buffer_parallel(&mesh, out_ptr, out_len, num_threads)
+    })
+}
+
+pub fn decode_mesh_with_options(
+    data: &[u8],
+    options: &crate::DecodeOptions,
+) -> Result<crate::MeshDecodeResult, DecodeError> {
+    DracoMesh::with_options(data, options)?.into_decoded()
+}
+
+/// Returns the attribute types whose output transform, e.g. dequantization,
+/// the Draco decode skips under the attribute filter of `options`.
+#[cfg(test)]
+pub(crate) fn skipped_transform_types(options: &crate::DecodeOptions) -> Vec<crate::AttributeType> {
+    use crate::AttributeType::*;
+    let bits = cpp::skipped_transform_types(&convert_options(options));
+    [Position, Normal, Color, TexCoord, Generic, Unknown]
+        .into_iter()
+        .filter(|&attribute_type| bits & 1 << attribute_type_id(attribute_type) != 0)
+        .collect()
+}
+
+pub fn probe_mesh(data: &[u8], options: &crate::DecodeOptions) -> Option<crate::MeshProbe> {
+    let mut probe = cpp::MeshProbe {
+        version_major: 0,
+        version_minor: 0,
+        encoder_method: 0,
+        flags: 0,
+        config: empty_config(),
+    };
+    if !cpp::probe_mesh(data, &convert_options(options), &mut probe) {
+        return None;
+    }
+    Some(crate::MeshProbe {
+        version: (probe.version_major, probe.version_minor),
+        encoder_method: match probe.encoder_method {
+            0 => crate::EncoderMethod::Sequential,
+            _ => crate::EncoderMethod::Edgebreaker,
+        },
+        has_metadata: probe.flags & METADATA_FLAG_MASK != 0,
+        config: convert_config(probe.config),
+    })
+}
+
+/// Timings and counters of one mesh decode (native, `perf` feature only).
+///
+/// Every phase is timed separately so a regression can be traced to the stage
+/// that caused it.
+#[cfg(feature = "perf")]
+#[derive(Clone, Debug, Default, PartialEq, Eq)]
+pub struct DecodeStats {
+    /// Time spent parsing the bitstream in Draco's `DecodeMeshFromBuffer`, in
+    /// nanoseconds.
+    pub parse_ns: u64,
+    /// Time spent computing the output layout, in nanoseconds.
+    pub config_ns: u64,
+    /// Time spent writing the index block, in nanoseconds.
+    pub index_write_ns: u64,
+    /// Write time of every attribute as `(unique_id, nanoseconds)`, in config
+    /// order.
+    pub attribute_write_ns: Vec<(u32, u64)>,
+    /// Size of the compressed input.
+    pub bytes_in: usize,
+    /// Size of the decoded buffer.
+    pub bytes_out: usize,
+    /// Heap allocations made by the C++ decoder through `operator new`.
+    pub allocations: u64,
+}
+
+#[cfg(feature = "perf")]
+pub fn decode_mesh_with_stats(data: &[u8]) -> Option<(crate::MeshDecodeResult, DecodeStats)> {
+    let mut stats = cpp::DecodeStats {
+        parse_ns: 0,
+        config_ns: 0,
+        index_write_ns: 0,
+        attribute_write_ns: Vec::new(),
+        bytes_in: 0,
+        bytes_out: 0,
+        allocations: 0,
     };
 
-    if !cpp::compute_mesh_config(&mesh, &mut cpp_config) {
-        panic!("Failed to compute mesh config");
+    let mut mesh = cpp::create_mesh_with_stats(data, &mut stats);
+    if mesh.is_null() {
+        return None;
+    }
+
+    let mut cpp_config = empty_config();
+    if !cpp::compute_mesh_config_with_stats(
+        mesh.pin_mut(),
+        &planar_options(),
+        &mut cpp_config,
+        &mut stats,
+    ) {
+        return None;
     }
 
     let buffer_size = cpp_config.buffer_size;
-    let config = convert_config(cpp_config);
-    let mut buffer = vec![0u8; buffer_size];
+    let mut buffer = Vec::new();
+    let written = write_uninit(&mut buffer, buffer_size, |out_ptr, out_len| unsafe {
+        cpp::decode_mesh_to_buffer_with_stats(&mesh, out_ptr, out_len, &mut stats)
+    });
+    if written != buffer_size {
+        return None;
+    }
 
-    let written = unsafe { cpp::decode_mesh_to_buffer(&mesh, buffer.as_mut_ptr(), buffer.len()) };
+    let stats = DecodeStats {
+        parse_ns: stats.parse_ns,
+        config_ns: stats.config_ns,
+        index_write_ns: stats.index_write_ns,
+        attribute_write_ns: stats
+            .attribute_write_ns
+            .iter()
+            .map(|time| (time.unique_id, time.nanoseconds))
+            .collect(),
+        bytes_in: stats.bytes_in,
+        bytes_out: stats.bytes_out,
+        allocations: stats.allocations,
+    };
+    let result = crate::MeshDecodeResult {
+        data: buffer,
+        config: convert_config(cpp_config),
+    };
+    Some((result, stats))
+}
 
-    if written == 0 {
-        panic!("Failed to decode mesh to buffer");
+fn decode_mesh(
+    data: &[u8],
+    options: &cpp::DecodeOptions,
+    write: impl FnOnce(Pin<&mut cpp::DracoMesh>, *mut u8, usize) -> usize,
+) -> Result<crate::MeshDecodeResult, DecodeError> {
+    let mut status = empty_status();
+    let mut mesh = cpp::create_mesh(data, options, &mut status);
+    if mesh.is_null() {
+        return Err(DecodeError::from_status(status));
     }
 
-    buffer.truncate(written);
+    let mut cpp_config = empty_config();
+    if !cpp::compute_mesh_config(mesh.pin_mut(), options, &mut cpp_config) {
+        return Err(DecodeError::InvalidOptions);
+    }
 
-    Some(crate::MeshDecodeResult {
+    let buffer_size = cpp_config.buffer_size;
+    let config = convert_config(cpp_config);
+    let mut buffer = Vec::new();
+
+    let written = write_uninit(&mut buffer, buffer_size, |out_ptr, out_len| {
+        write(mesh.pin_mut(), out_ptr, out_len)
+    });
+
+    if written != buffer_size {
+        return Err(DecodeError::WriteFailed);
+    }
+
+    Ok(crate::MeshDecodeResult {
         data: buffer,
         config,
     })
 }
+
+pub fn decode_mesh_batch(
+    blobs: &[&[u8]],
+    num_threads: usize,
+) -> Result<crate::BatchDecodeResult, BatchDecodeError> {
+    let blobs: Vec<cpp::DracoBlob> = blobs.iter().map(|&data| cpp::DracoBlob { data }).collect();
+
+    let mut cpp_configs = Vec::with_capacity(blobs.len());
+    let mut failed_index = 0;
+    let mut status = empty_status();
+    let batch = cpp::create_mesh_batch(
+        &blobs,
+        num_threads,
+        &mut cpp_configs,
+        &mut failed_index,
+        &mut status,
+    );
+    if batch.is_null() {
+        // An OK status means the mesh decoded but its layout failed.
+        let error = if status.code == 0 {
+            DecodeError::InvalidOptions
+        } else {
+            DecodeError::from_status(status)
+        };
+        return Err(BatchDecodeError {
+            index: failed_index,
+            error,
+        });
+    }
+
+    let mut offsets = Vec::with_capacity(cpp_configs.len());
+    let mut buffer_size = 0usize;
+    for cpp_config in &cpp_configs {
+        buffer_size = buffer_size.next_multiple_of(BATCH_MESH_ALIGNMENT);
+        offsets.push(buffer_size);
+        buffer_size += cpp_config.buffer_size;
+    }
+
+    let mut buffer = Vec::new();
+    let written = write_uninit(&mut buffer, buffer_size, |out_ptr, out_len| {
+        let ok = unsafe {
+            cpp::decode_mesh_batch_to_buffer(
+                &batch,
+                &offsets,
+                out_ptr,
+                out_len,
+                num_threads,
+                &mut failed_index,
+            )
+        };
+        if !ok {
+            return 0;
+        }
+        // The decoder only writes the meshes themselves, zero the alignment
+        // padding between them.
+        let mut end = 0;
+        for (offset, cpp_config) in offsets.iter().zip(&cpp_configs) {
+            unsafe { out_ptr.add(end).write_bytes(0, offset - end) };
+            end = offset + cpp_config.buffer_size;
+        }
+        out_len
+    });
+    if written != buffer_size {
+        return Err(BatchDecodeError {
+            index: failed_index,
+            error: DecodeError::WriteFailed,
+        });
+    }
+
+    Ok(crate::BatchDecodeResult {
+        data: buffer,
+        configs: cpp_configs.into_iter().map(convert_config).collect(),
+        offsets,
+    })
+}
+
+/// Error code of a `draco::Status`.
+#[derive(Clone, Copy, Debug, PartialEq, Eq, Hash)]
+pub enum StatusCode {
+    /// `DRACO_ERROR`, a generic failure such as corrupt data
+    Error,
+    /// `IO_ERROR`
+    IoError,
+    /// `INVALID_PARAMETER`
+    InvalidParameter,
+    /// `UNSUPPORTED_VERSION`, a bitstream version this Draco cannot decode
+    UnsupportedVersion,
+    /// `UNKNOWN_VERSION`
+    UnknownVersion,
+    /// `UNSUPPORTED_FEATURE`, e.g. an encoding this Draco was built without
+    UnsupportedFeature,
+}
+
+impl StatusCode {
+    fn from_draco(code: i32) -> Self {
+        match code {
+            -2 => StatusCode::IoError,
+            -3 => StatusCode::InvalidParameter,
+            -4 => StatusCode::UnsupportedVersion,
+            -5 => StatusCode::UnknownVersion,
+            -6 => StatusCode::UnsupportedFeature,
+            _ => StatusCode::Error,
+        }
+    }
+}
+
+/// Why a decode produced no mesh.
+#[derive(Clone, Debug, PartialEq, Eq)]
+pub enum DecodeError {
+    /// Draco rejected the data, with the code and message of its
+    /// `draco::Status`.
+    Draco { code: StatusCode, message: String },
+    /// The decode options cannot be applied to the mesh, e.g. an index format
+    /// too narrow for its vertex count.
+    InvalidOptions,
+    /// The output could not be written in the planned layout.
+    WriteFailed,
+    /// The decode would have used more memory than the budget of its
+    /// [`DecoderContext`].
+    OverBudget,
+    /// The [`OutputAllocator`] could not provide the output buffer.
+    AllocationFailed,
+}
+
+impl DecodeError {
+    fn from_status(status: cpp::DracoStatus) -> Self {
+        DecodeError::Draco {
+            code: StatusCode::from_draco(status.code),
+            message: status.message,
+        }
+    }
+}
+
+impl fmt::Display for DecodeError {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        match self {
+            DecodeError::Draco { code, message } => {
+                write!(f, "Draco decode failed ({code:?}): {message}")
+            }
+            DecodeError::InvalidOptions => f.write_str("invalid decode options"),
+            DecodeError::WriteFailed => f.write_str("failed to write the decoded mesh"),
+            DecodeError::OverBudget => f.write_str("decode exceeds the memory budget"),
+            DecodeError::AllocationFailed => f.write_str("output buffer allocation failed"),
+        }
+    }
+}
+
+impl std::error::Error for DecodeError {}
+
+/// Error of [`crate::decode_mesh_batch`]: the first blob of the batch that
+/// failed, and why.
+#[derive(Clone, Debug, PartialEq, Eq)]
+pub struct BatchDecodeError {
+    /// Index of the blob in the batch. When several blobs fail, the lowest.
+    pub index: usize,
+    /// Why the blob failed.
+    pub error: DecodeError,
+}
+
+impl fmt::Display for BatchDecodeError {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        write!(f, "blob {} of the batch: {}", self.index, self.error)
+    }
+}
+
+impl std::error::Error for BatchDecodeError {
+    fn source(&self) -> Option<&(dyn std::error::Error + 'static)> {
+        Some(&self.error)
+    }
+}
+
+/// A source of output buffers for [`DecoderContext::decode_mesh_with`], such
+/// as a bump arena, a pool of recycled buffers or mapped GPU memory.
+pub trait OutputAllocator {
+    /// Returns `size` bytes to write a decoded mesh to, or `None` if they are
+    /// not available. The previous contents are overwritten.
+    fn allocate(&mut self, size: usize) -> Option<&mut [u8]>;
+
+    /// Provides `size` bytes for `write` to fill and returns the leading bytes
+    /// it wrote, or `None` if the bytes are not available. `write` returns how
+    /// many bytes it wrote. The default writes into the bytes of
+    /// [`Self::allocate`]; override it to hand out memory that is not
+    /// initialized first.
+    ///
+    /// # Safety
+    ///
+    /// `write` must only store initialized bytes, and must initialize as many
+    /// leading bytes as it returns.
+    unsafe fn allocate_with(
+        &mut self,
+        size: usize,
+        write: &mut dyn FnMut(&mut [MaybeUninit<u8>]) -> usize,
+    ) -> Option<&mut [u8]> {
+        let out = self.allocate(size)?.get_mut(..size)?;
+        // SAFETY: `write` only stores initialized bytes, so `out` stays
+        // initialized.
+        let written = write(unsafe { &mut *(out as *mut [u8] as *mut [MaybeUninit<u8>]) });
+        out.get_mut(..written)
+    }
+}
+
+/// Reuses the vector, growing it to at least `size` bytes first.
+///
+/// [`OutputAllocator::allocate_with`] writes into the spare capacity and sets
+/// the length to the bytes written, like [`DecoderContext::decode_mesh_into`],
+/// so the output is not zeroed first.
+impl OutputAllocator for Vec<u8> {
+    fn allocate(&mut self, size: usize) -> Option<&mut [u8]> {
+        if self.len() < size {
+            self.try_reserve(size - self.len()).ok()?;
+            self.resize(size, 0);
+        }
+        Some(&mut self[..size])
+    }
+
+    unsafe fn allocate_with(
+        &mut self,
+        size: usize,
+        write: &mut dyn FnMut(&mut [MaybeUninit<u8>]) -> usize,
+    ) -> Option<&mut [u8]> {
+        self.clear();
+        self.try_reserve(size).ok()?;
+        let written = write(&mut self.spare_capacity_mut()[..size]);
+        assert!(written <= size, "decoder wrote past the output buffer");
+        // SAFETY: the caller's `write` initialized the first `written` bytes
+        // of the spare capacity.
+        unsafe { self.set_len(written) };
+        Some(self)
+    }
+}
+
+/// Long-lived decoder state that is reused across decodes (native only).
+///
+/// A context keeps the Draco decoder, the attribute scratch storage and the
+/// config between calls, and writes into a caller-owned buffer whose
+/// allocation is reused. Keep one context per worker thread when decoding
+/// many meshes.
+///
+/// [`DecoderContext::with_memory_budget`] bounds the memory of every decode,
+/// and [`DecoderContext::decode_mesh_with`] takes the output buffer from an
+/// [`OutputAllocator`] of your own.
+///
+/// # Example
+///
+/// ```ignore
+/// use draco_decoder::DecoderContext;
+///
+/// let mut context = DecoderContext::new();
+/// let mut buffer = Vec::new();
+/// for data in blobs {
+///     if let Some(config) = context.decode_mesh_into(data, &mut buffer) {
+///         println!("Vertices: {}", config.vertex_count());
+///     }
+/// }
+/// ```
+pub struct DecoderContext {
+    inner: cxx::UniquePtr<cpp::DecoderContext>,
+    cpp_config: cpp::MeshConfig,
+    config: crate::DracoDecodeConfig,
+    memory_budget: Option<usize>,
+    heap_bytes: usize,
+}
+
+impl DecoderContext {
+    /// Creates a new decoder context.
+    pub fn new() -> Self {
+        Self {
+            inner: cpp::create_decoder_context(),
+            cpp_config: empty_config(),
+            config: crate::DracoDecodeConfig::new(0, 0, 0),
+            memory_budget: None,
+            heap_bytes: 0,
+        }
+    }
+
+    /// Limits every decode of this context to `bytes` of memory: the C++
+    /// heap the Draco decode allocates for the mesh and its scratch storage,
+    /// plus the output buffer. The compressed input is not counted.
+    ///
+    /// A decode that passes the budget fails with [`DecodeError::OverBudget`].
+    /// By default the budget is checked once the mesh is decoded, against the
+    /// heap the mesh holds and the size of its output, before the output is
+    /// allocated. The check costs nothing beyond the decode, but does not stop
+    /// the decode itself from growing past the budget. With the `heap-budget`
+    /// feature the decode fails as soon as an allocation would cross the
+    /// budget; that feature replaces the global C++ `operator new` of the whole
+    /// process, so only enable it when no other linked C++ code replaces it as
+    /// well.
+    pub fn with_memory_budget(mut self, bytes: usize) -> Self {
+        self.memory_budget = Some(bytes);
+        self
+    }
+
+    /// Returns the memory budget of every decode, if any.
+    pub fn memory_budget(&self) -> Option<usize> {
+        self.memory_budget
+    }
+
+    /// Returns the C++ heap bytes the last decode allocated for the mesh
+    /// (held by the decoded mesh, without the `heap-budget` feature), which
+    /// are freed while its output is written. Useful to size a budget.
+    pub fn heap_bytes(&self) -> usize {
+        self.heap_bytes
+    }
+
+    /// Decodes a Draco compressed mesh into `out`.
+    ///
+    /// `out` is cleared and refilled with the decoded mesh buffer; its existing
+    /// capacity is reused, so passing the same `Vec` every time avoids a fresh
+    /// allocation once it has grown to the largest mesh size.
+    ///
+    /// # Returns
+    ///
+    /// Returns the config describing `out`, or `None` if decoding fails or
+    /// passes the memory budget. The config stays valid until the next decode
+    /// with this context.
+    pub fn decode_mesh_into(
+        &mut self,
+        data: &[u8],
+        out: &mut Vec<u8>,
+    ) -> Option<&crate::DracoDecodeConfig> {
+        out.clear();
+        let buffer_size = self.decode(data).ok()?;
+        let written = write_uninit(out, buffer_size, |out_ptr, out_len| unsafe {
+            cpp::context_write_mesh(self.inner.pin_mut(), out_ptr, out_len)
+        });
+        if written != buffer_size {
+            out.clear();
+            return None;
+        }
+
+        fill_config(&mut self.config, &self.cpp_config);
+        Some(&self.config)
+    }
+
+    /// Decodes a Draco compressed mesh into a buffer of `allocator`.
+    ///
+    /// # Returns
+    ///
+    /// Returns the config and the decoded mesh buffer, which is exactly
+    /// `config.buffer_size()` bytes long. The config stays valid until the
+    /// next decode with this context.
+    ///
+    /// # Errors
+    ///
+    /// Fails with [`DecodeError::OverBudget`] if the decode, including the
+    /// output buffer, would pass the memory budget; the allocator is not
+    /// called then.
+    pub fn decode_mesh_with<'a, A: OutputAllocator + ?Sized>(
+        &mut self,
+        data: &[u8],
+        allocator: &'a mut A,
+    ) -> Result<(&crate::DracoDecodeConfig, &'a mut [u8]), DecodeError> {
+        let buffer_size = self.decode(data)?;
+        let inner = &mut self.inner;
+        let mut write = |out: &mut [MaybeUninit<u8>]| unsafe {
+            cpp::context_write_mesh(inner.pin_mut(), out.as_mut_ptr().cast(), out.len())
+        };
+        // SAFETY: the decoder writes initialized bytes only, and returns how
+        // many it wrote.
+        let out = unsafe { allocator.allocate_with(buffer_size, &mut write) }
+            .ok_or(DecodeError::AllocationFailed)?;
+        if out.len() != buffer_size {
+            return Err(DecodeError::WriteFailed);
+        }
+
+        fill_config(&mut self.config, &self.cpp_config);
+        Ok((&self.config, out))
+    }
+
+    /// Decodes `data` into the C++ context within the memory budget and
+    /// returns the size of the output buffer, checked against the budget too.
+    fn decode(&mut self, data: &[u8]) -> Result<usize, DecodeError> {
+        let mut usage = cpp::HeapUsage {
+            bytes: 0,
+            over_budget: false,
+        };
+        // 0 is unlimited on the C++ side.
+        let budget = self.memory_budget.map_or(0, |bytes| bytes.max(1));
+        let mut status = empty_status();
+        let decoded = cpp::context_decode_mesh(
+            self.inner.pin_mut(),
+            data,
+            budget,
+            &mut self.cpp_config,
+            &mut usage,
+            &mut status,
+        );
+        self.heap_bytes = usage.bytes;
+        if !decoded {
+            return Err(if usage.over_budget {
+                DecodeError::OverBudget
+            } else {
+                DecodeError::from_status(status)
+            });
+        }
+
+        let buffer_size = self.cpp_config.buffer_size;
+        let needed = usage.bytes.saturating_add(buffer_size);
+        if self.memory_budget.is_some_and(|budget| needed > budget) {
+            return Err(DecodeError::OverBudget);
+        }
+        Ok(buffer_size)
+    }
+}
+
+impl Default for DecoderContext {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+/// A decoded Draco mesh whose layout is known before any output is written
+/// (native only).
+///
+/// [`DracoMesh::new`] runs the Draco decode and computes the config; the mesh
+/// can then be written into any caller-provided buffer, such as a mapped GPU
+/// staging buffer, without an intermediate `Vec`.
+///
+/// The layout is planned once, together with the config: the attribute order,
+/// the offsets, the index width and the writer of every attribute are
+/// resolved up front, so repeated writes skip straight to copying values.
+///
+/// # Example
+///
+/// ```ignore
+/// use draco_decoder::DracoMesh;
+///
+/// let mesh = DracoMesh::new(data).unwrap();
+/// let staging: &mut [u8] = map_staging_buffer(mesh.config().buffer_size());
+/// mesh.decode_into(staging).unwrap();
+/// ```
+pub struct DracoMesh {
+    inner: cxx::UniquePtr<cpp::DracoMesh>,
+    config: crate::DracoDecodeConfig,
+}
+
+impl DracoMesh {
+    /// Decodes a Draco compressed mesh and computes its planar output layout.
+    ///
+    /// Fails with the `draco::Status` of the decode if Draco rejects `data`.
+    pub fn new(data: &[u8]) -> Result<Self, DecodeError> {
+        Self::with_options(data, &crate::DecodeOptions::new())
+    }
+
+    /// Decodes a Draco compressed mesh and computes the output layout requested
+    /// by `options`. Every later write of this mesh uses that layout.
+    ///
+    /// Fails with the `draco::Status` of the decode if Draco rejects `data`,
+    /// or with [`DecodeError::InvalidOptions`].
+    pub fn with_options(data: &[u8], options: &crate::DecodeOptions) -> Result<Self, DecodeError> {
+        let options = convert_options(options);
+        let mut status = empty_status();
+        let mut inner = cpp::create_mesh(data, &options, &mut status);
+        if inner.is_null() {
+            return Err(DecodeError::from_status(status));
+        }
+
+        let mut cpp_config = empty_config();
+        if !cpp::compute_mesh_config(inner.pin_mut(), &options, &mut cpp_config) {
+            return Err(DecodeError::InvalidOptions);
+        }
+
+        Ok(Self {
+            inner,
+            config: convert_config(cpp_config),
+        })
+    }
+
+    /// Changes the output layout to the one requested by `options`, recomputing
+    /// the config without decoding the mesh again.
+    ///
+    /// Attributes dropped by the filter given to [`DracoMesh::with_options`] are
+    /// no longer available, so a new filter can only narrow the output. The
+    /// vertex order of [`crate::DecodeOptions::with_vertex_cache_optimization`]
+    /// is also fixed at decode time.
+    ///
+    /// Returns `false` and keeps the current layout if the options are invalid.
+    pub fn set_options(&mut self, options: &crate::DecodeOptions) -> bool {
+        let mut cpp_config = empty_config();
+        if !cpp::compute_mesh_config(
+            self.inner.pin_mut(),
+            &convert_options(options),
+            &mut cpp_config,
+        ) {
+            return false;
+        }
+        fill_config(&mut self.config, &cpp_config);
+        true
+    }
+
+    /// Returns the layout of the decoded buffer.
+    pub fn config(&self) -> &crate::DracoDecodeConfig {
+        &self.config
+    }
+
+    /// Writes the decoded mesh into the start of `out`.
+    ///
+    /// `out` must hold at least `config().buffer_size()` bytes; bytes past that
+    /// are left untouched.
+    ///
+    /// Returns the number of bytes written, or `None` if `out` is too small or
+    /// decoding fails.
+    pub fn decode_into(&self, out: &mut [u8]) -> Option<usize> {
+        self.write_into(out, |mesh, out_ptr, out_len| unsafe {
+            cpp::decode_mesh_to_buffer(mesh, out_ptr, out_len)
+        })
+    }
+
+    /// Like [`DracoMesh::decode_into`], but writes the index block and vertex
+    /// blocks on up to `num_threads` threads. `0` uses every hardware thread.
+    pub fn decode_into_parallel(&self, out: &mut [u8], num_threads: usize) -> Option<usize> {
+        self.write_into(out, |mesh, out_ptr, out_len| unsafe {
+            cpp::decode_mesh_to_buffer_parallel(mesh, out_ptr, out_len, num_threads)
+        })
+    }
+
+    /// Writes the decoded mesh into a new buffer.
+    ///
+    /// Fails with [`DecodeError::WriteFailed`] if an attribute cannot be
+    /// written in the planned layout.
+    pub fn decode(&self) -> Result<crate::MeshDecodeResult, DecodeError> {
+        let buffer_size = self.config.buffer_size();
+        let mut data = Vec::new();
+        let written = write_uninit(&mut data, buffer_size, |out_ptr, out_len| unsafe {
+            cpp::decode_mesh_to_buffer(&self.inner, out_ptr, out_len)
+        });
+        if written != buffer_size {
+            return Err(DecodeError::WriteFailed);
+        }
+        Ok(crate::MeshDecodeResult {
+            data,
+            config: self.config.clone(),
+        })
+    }
+
+    /// Like [`DracoMesh::decode_into`], but consumes the mesh: the Draco
+    /// storage of every attribute is freed as soon as its values are written,
+    /// and the faces once the indices are, so the decoded mesh and the output
+    /// are never both held in full.
+    pub fn consume_into(mut self, out: &mut [u8]) -> Option<usize> {
+        let buffer_size = self.config.buffer_size();
+        if out.len() < buffer_size {
+            return None;
+        }
+        let written = unsafe {
+            cpp::consume_mesh_to_buffer(self.inner.pin_mut(), out.as_mut_ptr(), buffer_size)
+        };
+        (written == buffer_size).then_some(written)
+    }
+
+    /// Like [`DracoMesh::decode`], but consumes the mesh and frees its Draco
+    /// storage while writing, as [`DracoMesh::consume_into`] does.
+    pub fn into_decoded(mut self) -> Result<crate::MeshDecodeResult, DecodeError> {
+        let buffer_size = self.config.buffer_size();
+        let mut data = Vec::new();
+        let written = write_uninit(&mut data, buffer_size, |out_ptr, out_len| unsafe {
+            cpp::consume_mesh_to_buffer(self.inner.pin_mut(), out_ptr, out_len)
+        });
+        if written != buffer_size {
+            return Err(DecodeError::WriteFailed);
+        }
+        Ok(crate::MeshDecodeResult {
+            data,
+            config: self.config,
+        })
+    }
+
+    fn write_into(
+        &self,
+        out: &mut [u8],
+        write: impl FnOnce(&cpp::DracoMesh, *mut u8, usize) -> usize,
+    ) -> Option<usize> {
+        let buffer_size = self.config.buffer_size();
+        if out.len() < buffer_size {
+            return None;
+        }
+        let written = write(&self.inner, out.as_mut_ptr(), buffer_size);
+        (written == buffer_size).then_some(written)
+    }
+}
+
+/// A decoded Draco point cloud (native only).
+///
+/// The point cloud is decoded once by [`DracoPointCloud::new`]; its attributes
+/// can then be written out whole with [`DracoPointCloud::decode`] or streamed in
+/// fixed-size blocks with [`DracoPointCloud::chunks`], so a large cloud is never
+/// held in two full copies.
+pub struct DracoPointCloud {
+    inner: cxx::UniquePtr<cpp::DracoPointCloud>,
+    num_points: u32,
+}
+
+impl DracoPointCloud {
+    /// Decodes a Draco compressed point cloud.
+    ///
+    /// Fails with the `draco::Status` of the decode if Draco rejects `data`.
+    pub fn new(data: &[u8]) -> Result<Self, DecodeError> {
+        let mut status = empty_status();
+        let inner = cpp::create_point_cloud(data, &mut status);
+        if inner.is_null() {
+            return Err(DecodeError::from_status(status));
+        }
+        let num_points = cpp::point_cloud_num_points(&inner);
+        Ok(Self { inner, num_points })
+    }
+
+    /// Returns the number of points in the cloud.
+    pub fn num_points(&self) -> u32 {
+        self.num_points
+    }
+
+    /// Writes every attribute of the whole cloud into one buffer.
+    ///
+    /// Fails with [`DecodeError::WriteFailed`] if an attribute cannot be
+    /// written.
+    pub fn decode(&self) -> Result<crate::MeshDecodeResult, DecodeError> {
+        let mut data = Vec::new();
+        let config = self
+            .decode_points_into(0, self.num_points, &mut data)
+            .ok_or(DecodeError::WriteFailed)?;
+        Ok(crate::MeshDecodeResult { data, config })
+    }
+
+    /// Writes every attribute of `num_points` points starting at `first_point`
+    /// into `out`, reusing its allocation.
+    ///
+    /// The layout matches [`DracoPointCloud::decode`] for a cloud of `num_points`
+    /// points: one tightly packed block per attribute, in unique id order.
+    ///
+    /// Returns the config describing `out`, or `None` if the range is out of
+    /// bounds or decoding fails.
+    pub fn decode_points_into(
+        &self,
+        first_point: u32,
+        num_points: u32,
+        out: &mut Vec<u8>,
+    ) -> Option<crate::DracoDecodeConfig> {
+        out.clear();
+        if first_point.checked_add(num_points)? > self.num_points {
+            return None;
+        }
+
+        let mut cpp_config = empty_config();
+        if !cpp::compute_point_cloud_config(&self.inner, num_points, &mut cpp_config) {
+            return None;
+        }
+
+        let buffer_size = cpp_config.buffer_size;
+        let written = write_uninit(out, buffer_size, |out_ptr, out_len| unsafe {
+            cpp::decode_point_cloud_to_buffer(
+                &self.inner,
+                first_point,
+                num_points,
+                out_ptr,
+                out_len,
+            )
+        });
+        if written != buffer_size {
+            out.clear();
+            return None;
+        }
+        Some(convert_config(cpp_config))
+    }
+
+    /// Deepest grid of [`DracoPointCloud::chunk_spatially`], 128 cells per axis.
+    pub const MAX_CHUNK_DEPTH: u32 = 7;
+
+    /// Sorts the points into the cells of a grid of `2^depth` cells per axis
+    /// over the bounds of the positions, and returns the range and bounds of
+    /// every non-empty cell.
+    ///
+    /// The cells come in Morton order, so the cells of one octree node at any
+    /// coarser depth are contiguous too: for culling and LOD the chunks sharing
+    /// `cell >> (3 * k)` form the node `k` levels up. Within a cell the points
+    /// keep their order. Only the point to value mapping of the attributes
+    /// changes; the values are gathered in the new order by the next
+    /// [`DracoPointCloud::decode`] or [`DracoPointCloud::decode_points_into`],
+    /// so a chunk is uploaded on its own by decoding its point range.
+    ///
+    /// Returns `None` if the cloud has no 3D positions or `depth` is above
+    /// [`DracoPointCloud::MAX_CHUNK_DEPTH`].
+    pub fn chunk_spatially(&mut self, depth: u32) -> Option<Vec<SpatialChunk>> {
+        let mut chunks = Vec::new();
+        if !cpp::chunk_point_cloud(self.inner.pin_mut(), depth, &mut chunks) {
+            return None;
+        }
+        Some(chunks.into_iter().map(SpatialChunk::from).collect())
+    }
+
+    /// Returns an iterator over consecutive blocks of `points_per_chunk` points.
+    ///
+    /// Each item is laid out like [`DracoPointCloud::decode_points_into`]; the last
+    /// block may be shorter. Iteration stops at the first block that fails to
+    /// decode.
+    ///
+    /// # Panics
+    ///
+    /// Panics if `points_per_chunk` is 0.
+    pub fn chunks(&self, points_per_chunk: u32) -> PointCloudChunks<'_> {
+        assert!(points_per_chunk > 0, "points_per_chunk must be non-zero");
+        PointCloudChunks {
+            cloud: self,
+            next_point: 0,
+            points_per_chunk,
+        }
+    }
+}
+
+/// One cell of a spatially chunked [`DracoPointCloud`], see
+/// [`DracoPointCloud::chunk_spatially`].
+#[derive(Clone, Copy, Debug, PartialEq)]
+pub struct SpatialChunk {
+    /// First point of the cell in the reordered cloud.
+    pub first_point: u32,
+    /// Number of points in the cell.
+    pub num_points: u32,
+    /// Morton code of the cell, with x in the lowest bit.
+    pub cell: u32,
+    /// Smallest position of the points in the cell.
+    pub min: [f32; 3],
+    /// Largest position of the points in the cell.
+    pub max: [f32; 3],
+}
+
+impl From<cpp::SpatialChunk> for SpatialChunk {
+    fn from(chunk: cpp::SpatialChunk) -> Self {
+        Self {
+            first_point: chunk.first_point,
+            num_points: chunk.num_points,
+            cell: chunk.cell,
+            min: chunk.min,
+            max: chunk.max,
+        }
+    }
+}
+
+/// Iterator over fixed-size blocks of a [`DracoPointCloud`].
+///
+/// Created by [`DracoPointCloud::chunks`].
+pub struct PointCloudChunks<'a> {
+    cloud: &'a DracoPointCloud,
+    next_point: u32,
+    points_per_chunk: u32,
+}
+
+impl Iterator for PointCloudChunks<'_> {
+    type Item = crate::MeshDecodeResult;
+
+    fn next(&mut self) -> Option<Self::Item> {
+        let remaining = self.cloud.num_points - self.next_point;
+        if remaining == 0 {
+            return None;
+        }
+
+        let num_points = remaining.min(self.points_per_chunk);
+        let mut data = Vec::new();
+        let Some(config) = self
+            .cloud
+            .decode_points_into(self.next_point, num_points, &mut data)
+        else {
+            self.next_point = self.cloud.num_points;
+            return None;
+        };
+        self.next_point += num_points;
+        Some(crate::MeshDecodeResult { data, config })
+    }
+}
@@ -0,0 +1,450 @@
+//! Decoding straight from memory-mapped `.drc`, `.glb` and `.gltf` files
+//! (native only).
+
+use std::collections::VecDeque;
+use std::fs::File;
+use std::io;
+use std::ops::Range;
+use std::path::Path;
+use std::pin::Pin;
+use std::sync::Arc;
+use std::task::{Context, Poll, Wake, Waker};
+use std::thread::{self, Thread};
+
+use memmap2::Mmap;
+
+use crate::{DecodeError, DecodeOptions, DecodePool, DecodeTask, MeshDecodeResult, PoolError};
+
+const GLB_MAGIC: u32 = 0x4654_6C67; // "glTF"
+const GLB_CHUNK_JSON: u32 = 0x4E4F_534A;
+const GLB_CHUNK_BIN: u32 = 0x004E_4942;
+const GLB_HEADER_LEN: usize = 12;
+const GLB_CHUNK_HEADER_LEN: usize = 8;
+
+/// A Draco compressed primitive inside a [`DracoFile`].
+#[derive(Clone, Debug, PartialEq, Eq)]
+pub struct DracoPrimitive {
+    mesh: usize,
+    primitive: usize,
+    map: usize,
+    range: Range<usize>,
+    attributes: Vec<(String, u32)>,
+}
+
+impl DracoPrimitive {
+    /// Returns the index of the glTF mesh holding the primitive, 0 for `.drc`.
+    pub fn mesh_index(&self) -> usize {
+        self.mesh
+    }
+
+    /// Returns the index of the primitive in its glTF mesh, 0 for `.drc`.
+    pub fn primitive_index(&self) -> usize {
+        self.primitive
+    }
+
+    /// Returns the byte range of the compressed data in the file holding it:
+    /// the `.drc` or `.glb` itself, or the external buffer of a `.gltf`.
+    pub fn byte_range(&self) -> Range<usize> {
+        self.range.clone()
+    }
+
+    /// Returns the glTF attribute semantics and the unique id of the Draco
+    /// attribute holding each, empty for `.drc`.
+    pub fn attributes(&self) -> &[(String, u32)] {
+        &self.attributes
+    }
+}
+
+/// A memory-mapped `.drc`, `.glb` or `.gltf` file.
+///
+/// The compressed data is decoded in place from the mapping, so the file is
+/// never read into memory as a whole, and only the pages Draco touches are
+/// loaded. A `.glb` or `.gltf` exposes every primitive with
+/// `KHR_draco_mesh_compression` stored in the binary chunk or in an external
+/// buffer file, which is mapped as well; `data:` URIs are not supported. Any
+/// other file is a single Draco primitive.
+///
+/// The files must not be truncated or modified while they are open.
+///
+/// # Example
+///
+/// ```ignore
+/// use draco_decoder::DracoFile;
+///
+/// let file = DracoFile::open("tile.glb")?;
+/// for primitive in file.primitives() {
+///     let result = file.decode(primitive).expect("Decode failed");
+///     println!("{} vertices", result.config.vertex_count());
+/// }
+/// ```
+pub struct DracoFile {
+    maps: Vec<Mmap>,
+    primitives: Vec<DracoPrimitive>,
+}
+
+impl DracoFile {
+    /// Maps the file at `path` and locates its Draco primitives.
+    ///
+    /// Fails with [`io::ErrorKind::InvalidData`] if a `.glb` or `.gltf` is
+    /// malformed, or with the error of mapping an external buffer.
+    pub fn open(path: impl AsRef<Path>) -> io::Result<Self> {
+        let path = path.as_ref();
+        let map = map_file(path)?;
+        let mut maps = Vec::new();
+        let primitives = if read_u32(&map, 0) == Some(GLB_MAGIC) {
+            glb_primitives(&map, path, &mut maps)?
+        } else if map.iter().find(|b| !b.is_ascii_whitespace()) == Some(&b'{') {
+            gltf_primitives(&map, path, &mut maps)?
+        } else {
+            vec![DracoPrimitive {
+                mesh: 0,
+                primitive: 0,
+                map: 0,
+                range: 0..map.len(),
+                attributes: Vec::new(),
+            }]
+        };
+        maps.insert(0, map);
+        Ok(Self { maps, primitives })
+    }
+
+    /// Returns the Draco primitives of the file, in glTF mesh order.
+    pub fn primitives(&self) -> &[DracoPrimitive] {
+        &self.primitives
+    }
+
+    /// Returns the compressed data of `primitive`, borrowed from the mapping.
+    pub fn data(&self, primitive: &DracoPrimitive) -> &[u8] {
+        &self.maps[primitive.map][primitive.range.clone()]
+    }
+
+    /// Decodes `primitive` like [`crate::decode_mesh_with_config_sync`].
+    pub fn decode(&self, primitive: &DracoPrimitive) -> Result<MeshDecodeResult, DecodeError> {
+        crate::ffi::decode_mesh_with_config(self.data(primitive))
+    }
+
+    /// Decodes every primitive on `pool` with `options`, submitting the
+    /// primitives with the least compressed data first, and returns them as
+    /// they finish. Small primitives take the least time to decode, so the
+    /// first geometry is ready as early as possible.
+    ///
+    /// See [`DracoFile::decode_stream_by_key`].
+    pub fn decode_stream<'a>(
+        self: Arc<Self>,
+        pool: &'a DecodePool,
+        options: &DecodeOptions,
+    ) -> PrimitiveStream<'a> {
+        self.decode_stream_by_key(pool, options, |primitive| primitive.range.len())
+    }
+
+    /// Decodes every primitive on `pool` with `options`, submitted in
+    /// ascending order of `key`, and returns them as they finish.
+    ///
+    /// At most twice as many primitives as `pool` has threads are decoding or
+    /// waiting to be taken at a time, so the stream keeps the pool busy while
+    /// the caller consumes results, without holding the whole scene decoded.
+    pub fn decode_stream_by_key<'a, K: Ord>(
+        self: Arc<Self>,
+        pool: &'a DecodePool,
+        options: &DecodeOptions,
+        mut key: impl FnMut(&DracoPrimitive) -> K,
+    ) -> PrimitiveStream<'a> {
+        let mut order: Vec<usize> = (0..self.primitives.len()).collect();
+        order.sort_by_cached_key(|&index| key(&self.primitives[index]));
+        PrimitiveStream {
+            file: self,
+            pool,
+            options: options.clone(),
+            order: order.into(),
+            running: Vec::new(),
+            window: pool.num_threads() * 2,
+        }
+    }
+}
+
+/// The primitives of a [`DracoFile`] decoding on a [`DecodePool`], created by
+/// [`DracoFile::decode_stream`].
+///
+/// Every primitive is returned once, with its decode result, as soon as it is
+/// ready. Poll it with [`PrimitiveStream::next_decoded`] from async code, or
+/// iterate over it to block the current thread instead. Dropping the stream
+/// cancels the decodes that have not started.
+///
+/// # Example
+///
+/// ```ignore
+/// use std::sync::Arc;
+/// use draco_decoder::{DecodeOptions, DecodePool, DracoFile};
+///
+/// let file = Arc::new(DracoFile::open("tile.gltf")?);
+/// let mut stream = file.decode_stream(DecodePool::global(), &DecodeOptions::new());
+/// while let Some((primitive, result)) = stream.next_decoded().await {
+///     upload(primitive.mesh_index(), result?);
+/// }
+/// ```
+pub struct PrimitiveStream<'a> {
+    file: Arc<DracoFile>,
+    pool: &'a DecodePool,
+    options: DecodeOptions,
+    order: VecDeque<usize>,
+    running: Vec<(usize, DecodeTask<MeshDecodeResult>)>,
+    window: usize,
+}
+
+impl PrimitiveStream<'_> {
+    /// Returns the number of primitives not returned yet.
+    pub fn remaining(&self) -> usize {
+        self.order.len() + self.running.len()
+    }
+
+    /// Waits for the next decoded primitive, or returns `None` once every
+    /// primitive has been returned.
+    pub async fn next_decoded(
+        &mut self,
+    ) -> Option<(DracoPrimitive, Result<MeshDecodeResult, PoolError>)> {
+        std::future::poll_fn(|cx| self.poll_next(cx)).await
+    }
+
+    /// Returns the next decoded primitive if one is ready, `None` once every
+    /// primitive has been returned, and otherwise wakes `cx` when one is
+    /// ready. The signature matches `Stream::poll_next` of the futures crate.
+    pub fn poll_next(
+        &mut self,
+        cx: &mut Context<'_>,
+    ) -> Poll<Option<(DracoPrimitive, Result<MeshDecodeResult, PoolError>)>> {
+        self.submit();
+        if self.running.is_empty() {
+            return Poll::Ready(None);
+        }
+        for i in 0..self.running.len() {
+            if let Poll::Ready(result) = Pin::new(&mut self.running[i].1).poll(cx) {
+                let (index, _) = self.running.remove(i);
+                // Keep the pool busy while the caller handles this one.
+                self.submit();
+                return Poll::Ready(Some((self.file.primitives[index].clone(), result)));
+            }
+        }
+        Poll::Pending
+    }
+
+    /// Submits primitives in priority order until the window is full.
+    fn submit(&mut self) {
+        while self.running.len() < self.window {
+            let Some(index) = self.order.pop_front() else {
+                return;
+            };
+            let file = self.file.clone();
+            let options = self.options.clone();
+            let task = self.pool.spawn(move || {
+                let data = file.data(&file.primitives[index]);
+                crate::ffi::decode_mesh_with_options(data, &options).ok()
+            });
+            self.running.push((index, task));
+        }
+    }
+}
+
+impl Iterator for PrimitiveStream<'_> {
+    type Item = (DracoPrimitive, Result<MeshDecodeResult, PoolError>);
+
+    /// Blocks the current thread until the next primitive is decoded.
+    fn next(&mut self) -> Option<Self::Item> {
+        let waker = Waker::from(Arc::new(ThreadWaker(thread::current())));
+        let mut cx = Context::from_waker(&waker);
+        loop {
+            if let Poll::Ready(item) = self.poll_next(&mut cx) {
+                return item;
+            }
+            thread::park();
+        }
+    }
+
+    fn size_hint(&self) -> (usize, Option<usize>) {
+        (self.remaining(), Some(self.remaining()))
+    }
+}
+
+struct ThreadWaker(Thread);
+
+impl Wake for ThreadWaker {
+    fn wake(self: Arc<Self>) {
+        self.0.unpark();
+    }
+}
+
+/// Decodes the mesh of a `.drc` file, or the first Draco primitive of a `.glb`,
+/// without reading the file into memory first.
+///
+/// Fails with [`io::ErrorKind::InvalidData`] if there is no Draco primitive or
+/// decoding fails.
+pub fn decode_mesh_from_path(path: impl AsRef<Path>) -> io::Result<MeshDecodeResult> {
+    let file = DracoFile::open(path)?;
+    let primitive = file
+        .primitives()
+        .first()
+        .ok_or_else(|| invalid_data("no Draco compressed primitive"))?;
+    file.decode(primitive)
+        .map_err(|error| invalid_data(&error.to_string()))
+}
+
+fn map_file(path: &Path) -> io::Result<Mmap> {
+    let file = File::open(path)?;
+    // SAFETY: the mapping is read only and the caller keeps the file
+    // unchanged while it is open, as documented on `DracoFile`.
+    unsafe { Mmap::map(&file) }
+}
+
+fn invalid_data(message: &str) -> io::Error {
+    io::Error::new(io::ErrorKind::InvalidData, message)
+}
+
+fn read_u32(data: &[u8], at: usize) -> Option<u32> {
+    let bytes = data.get(at..at.checked_add(4)?)?;
+    Some(u32::from_le_bytes(bytes.try_into().unwrap()))
+}
+
+/// Returns the byte range of the data of the chunk at `at`, and its type.
+fn glb_chunk(data: &[u8], at: usize) -> io::Result<(Range<usize>, u32)> {
+    let malformed = || invalid_data("truncated glb chunk");
+    let length = read_u32(data, at).ok_or_else(malformed)? as usize;
+    let kind = read_u32(data, at + 4).ok_or_else(malformed)?;
+    let start = at + GLB_CHUNK_HEADER_LEN;
+    let end = start.checked_add(length).ok_or_else(malformed)?;
+    if end > data.len() {
+        return Err(malformed());
+    }
+    Ok((start..end, kind))
+}
+
+/// Locates the Draco primitives of a `.glb`. Only the JSON chunk is parsed;
+/// buffer 0 without a uri is the binary chunk.
+fn glb_primitives(
+    data: &[u8],
+    path: &Path,
+    maps: &mut Vec<Mmap>,
+) -> io::Result<Vec<DracoPrimitive>> {
+    let (json_range, kind) = glb_chunk(data, GLB_HEADER_LEN)?;
+    if kind != GLB_CHUNK_JSON {
+        return Err(invalid_data("glb does not start with a JSON chunk"));
+    }
+    let bin = if json_range.end.next_multiple_of(4) < data.len() {
+        let (range, kind) = glb_chunk(data, json_range.end.next_multiple_of(4))?;
+        (kind == GLB_CHUNK_BIN).then_some(range)
+    } else {
+        None
+    };
+    draco_primitives(&data[json_range], path, bin, maps)
+}
+
+/// Locates the Draco primitives of a `.gltf`, whose buffers are files next to
+/// it.
+fn gltf_primitives(
+    data: &[u8],
+    path: &Path,
+    maps: &mut Vec<Mmap>,
+) -> io::Result<Vec<DracoPrimitive>> {
+    draco_primitives(data, path, None, maps)
+}
+
+/// The mapping holding a glTF buffer and its byte range in it, `None` if the
+/// buffer is not available.
+type BufferExtent = Option<(usize, Range<usize>)>;
+
+/// Locates the primitives with `KHR_draco_mesh_compression` in the glTF JSON
+/// `json`. `bin` is the binary chunk of a `.glb` in the mapping of `path`;
+/// external buffers holding Draco data are mapped and appended to `maps`, at
+/// their index plus one.
+fn draco_primitives(
+    json: &[u8],
+    path: &Path,
+    bin: Option<Range<usize>>,
+    maps: &mut Vec<Mmap>,
+) -> io::Result<Vec<DracoPrimitive>> {
+    let gltf: serde_json::Value = serde_json::from_slice(json)
+        .map_err(|error| invalid_data(&format!("invalid glTF JSON: {error}")))?;
+
+    // Extent of every buffer, resolved on first use.
+    let buffer_count = gltf["buffers"].as_array().map_or(0, Vec::len);
+    let mut buffers: Vec<Option<BufferExtent>> = vec![None; buffer_count];
+    let mut resolve = |index: usize| -> io::Result<BufferExtent> {
+        let Some(cached) = buffers.get(index) else {
+            return Err(invalid_data("Draco buffer view refers to a missing buffer"));
+        };
+        if let Some(buffer) = cached {
+            return Ok(buffer.clone());
+        }
+        let json = &gltf["buffers"][index];
+        let buffer = match json["uri"].as_str() {
+            None => bin.clone().filter(|_| index == 0).map(|range| (0, range)),
+            Some(uri) if uri.starts_with("data:") => None,
+            Some(uri) => {
+                let map = map_file(&path.parent().unwrap_or(Path::new("")).join(uri))?;
+                maps.push(map);
+                Some((maps.len(), 0..maps[maps.len() - 1].len()))
+            }
+        };
+        // A buffer is no longer than its byteLength, nor than the bytes mapped.
+        let buffer = buffer.map(|(map, mut range)| {
+            if let Some(length) = json["byteLength"].as_u64() {
+                let length = usize::try_from(length).unwrap_or(usize::MAX);
+                range.end = range.end.min(range.start.saturating_add(length));
+            }
+            (map, range)
+        });
+        buffers[index] = Some(buffer.clone());
+        Ok(buffer)
+    };
+
+    let mut primitives = Vec::new();
+    let meshes = gltf["meshes"]
+        .as_array()
+        .map(Vec::as_slice)
+        .unwrap_or_default();
+    for (m, mesh) in meshes.iter().enumerate() {
+        let list = mesh["primitives"]
+            .as_array()
+            .map(Vec::as_slice)
+            .unwrap_or_default();
+        for (p, primitive) in list.iter().enumerate() {
+            let draco = &primitive["extensions"]["KHR_draco_mesh_compression"];
+            let Some(view) = draco["bufferView"].as_u64() else {
+                continue;
+            };
+            let view = &gltf["bufferViews"][usize::try_from(view).unwrap_or(usize::MAX)];
+            if !view.is_object() {
+                return Err(invalid_data(
+                    "Draco primitive refers to a missing buffer view",
+                ));
+            }
+            let buffer = view["buffer"].as_u64().unwrap_or(0);
+            let Some((map, extent)) = resolve(usize::try_from(buffer).unwrap_or(usize::MAX))?
+            else {
+                continue;
+            };
+            let exceeds = || invalid_data("Draco buffer view exceeds its buffer");
+            let offset = usize::try_from(view["byteOffset"].as_u64().unwrap_or(0));
+            let length = usize::try_from(view["byteLength"].as_u64().unwrap_or(0));
+            let (offset, length) = offset.ok().zip(length.ok()).ok_or_else(exceeds)?;
+            let start = extent.start.checked_add(offset).ok_or_else(exceeds)?;
+            if start.checked_add(length).is_none_or(|end| end > extent.end) {
+                return Err(exceeds());
+            }
+
+            let mut attributes: Vec<(String, u32)> = draco["attributes"]
+                .as_object()
+                .into_iter()
+                .flatten()
+                .filter_map(|(name, id)| Some((name.clone(), id.as_u64()? as u32)))
+                .collect();
+            attributes.sort_by_key(|&(_, id)| id);
+            primitives.push(DracoPrimitive {
+                mesh: m,
+                primitive: p,
+                map,
+                range: start..start + length,
+                attributes,
+            });
+        }
+    }
+    Ok(primitives)
+}
@@ -14,14 +14,37 @@
 //! }
 //! ```
 
+#[cfg(not(target_arch = "wasm32"))]
+mod cache;
 #[cfg(not(target_arch = "wasm32"))]
 mod ffi;
+#[cfg(not(target_arch = "wasm32"))]
+mod file;
+#[cfg(not(target_arch = "wasm32"))]
+mod pool;
 pub mod utils;
 #[cfg(target_arch = "wasm32")]
 mod wasm;
 
+#[cfg(not(target_arch = "wasm32"))]
+pub use cache::{CacheStats, DecodeCache};
+#[cfg(not(target_arch = "wasm32"))]
+pub use ffi::{
+    BatchDecodeError, DecodeError, DecoderContext, DracoMesh, DracoPointCloud, OutputAllocator,
+    PointCloudChunks, SpatialChunk, StatusCode,
+};
+#[cfg(not(target_arch = "wasm32"))]
+pub use file::{DracoFile, DracoPrimitive, PrimitiveStream, decode_mesh_from_path};
+#[cfg(not(target_arch = "wasm32"))]
+pub use pool::{DecodePool, DecodeTask, PoolError};
+
+#[cfg(all(not(target_arch = "wasm32"), feature = "perf"))]
+pub use ffi::DecodeStats;
+
 pub use utils::{
-    AttributeDataType, AttributeValues, DracoDecodeConfig, MeshAttribute, MeshDecodeResult,
+    AttributeDataType, AttributeType, AttributeValues, BatchDecodeResult, DecodeOptions,
+    DracoDecodeConfig, EncoderMethod, IndexFormat, MAX_QUANTIZED_COMPONENTS, MeshAttribute,
+    MeshDecodeResult, MeshProbe, NormalFormat, QuantizationInfo, VertexLayout,
 };
 
 /// Decodes a Draco compressed mesh asynchronously.
@@ -29,6 +52,11 @@ pub use utils::{
 /// This function automatically decodes the mesh and extracts metadata including
 /// vertex count, index count, and attribute information.
 ///
+/// On native targets the decode runs on [`DecodePool::global`], so the polling
+/// executor thread is never blocked; `data` is copied for the pool thread.
+/// Dropping the future cancels the decode if it has not started. Use a
+/// [`DecodePool`] of your own to bound concurrency and queueing.
+///
 /// # Arguments
 ///
 /// * `data` - The Draco encoded mesh data
@@ -56,7 +84,7 @@ pub use utils::{
 /// ```
 #[cfg(not(target_arch = "wasm32"))]
 pub async fn decode_mesh_with_config(data: &[u8]) -> Option<MeshDecodeResult> {
-    ffi::decode_mesh_with_config(data)
+    DecodePool::global().decode(data.to_vec()).await.ok()
 }
 
 /// Decodes a Draco compressed mesh synchronously (native only).
@@ -70,16 +98,212 @@ pub async fn decode_mesh_with_config(data: &[u8]) -> Option<MeshDecodeResult> {
 ///
 /// # Returns
 ///
-/// Returns `Some(MeshDecodeResult)` on success, containing:
+/// Returns `Ok(MeshDecodeResult)` on success, containing:
 /// - `data` - The decoded mesh buffer
 /// - `config` - Metadata about the decoded mesh
 ///
-/// Returns `None` if decoding fails.
+/// Returns [`DecodeError::Draco`] with the code and message of the
+/// `draco::Status` if Draco rejects `data`. A bad input costs one error
+/// return; nothing panics.
 #[cfg(not(target_arch = "wasm32"))]
-pub fn decode_mesh_with_config_sync(data: &[u8]) -> Option<MeshDecodeResult> {
+pub fn decode_mesh_with_config_sync(data: &[u8]) -> Result<MeshDecodeResult, DecodeError> {
     ffi::decode_mesh_with_config(data)
 }
 
+/// Decodes a Draco compressed mesh synchronously and reports where the time went
+/// (native, `perf` feature only).
+///
+/// Produces the same result as [`decode_mesh_with_config_sync`] together with
+/// the timing of every phase, the byte counts and the C++ allocation count.
+///
+/// # Arguments
+///
+/// * `data` - The Draco encoded mesh data
+///
+/// # Returns
+///
+/// Returns `Some((MeshDecodeResult, DecodeStats))` on success, `None` if
+/// decoding fails.
+///
+/// # Example
+///
+/// ```ignore
+/// use draco_decoder::decode_mesh_with_stats_sync;
+///
+/// let (result, stats) = decode_mesh_with_stats_sync(data).unwrap();
+/// println!("parse: {} ns, indices: {} ns", stats.parse_ns, stats.index_write_ns);
+/// ```
+#[cfg(all(not(target_arch = "wasm32"), feature = "perf"))]
+pub fn decode_mesh_with_stats_sync(data: &[u8]) -> Option<(MeshDecodeResult, DecodeStats)> {
+    ffi::decode_mesh_with_stats(data)
+}
+
+/// Decodes a Draco compressed mesh synchronously in a custom layout (native only).
+///
+/// The vertex blocks are written directly in the layout requested by
+/// `options`, e.g. fully interleaved vertices, so no second pass is needed to
+/// re-arrange them. The offset and [`MeshAttribute::byte_stride`] of every
+/// attribute in the returned config describe where its values are.
+///
+/// # Arguments
+///
+/// * `data` - The Draco encoded mesh data
+/// * `options` - The requested vertex layout and alignment
+///
+/// # Returns
+///
+/// Returns `Ok(MeshDecodeResult)` on success, [`DecodeError::Draco`] if Draco
+/// rejects `data`, or [`DecodeError::InvalidOptions`].
+///
+/// # Example
+///
+/// ```ignore
+/// use draco_decoder::{DecodeOptions, VertexLayout, decode_mesh_with_options_sync};
+///
+/// let options = DecodeOptions::new().with_layout(VertexLayout::Interleaved);
+/// let result = decode_mesh_with_options_sync(data, &options).unwrap();
+/// let stride = result.config.attributes()[0].byte_stride();
+/// ```
+#[cfg(not(target_arch = "wasm32"))]
+pub fn decode_mesh_with_options_sync(
+    data: &[u8],
+    options: &DecodeOptions,
+) -> Result<MeshDecodeResult, DecodeError> {
+    ffi::decode_mesh_with_options(data, options)
+}
+
+/// Reads the header, connectivity and attribute descriptors of a Draco mesh
+/// without decoding any attribute value (native only).
+///
+/// The returned config matches the one the decode with `options` produces, so
+/// the buffer size, index width and attribute layout are known up front, e.g.
+/// to reserve memory or reject a mesh that does not fit a budget. With
+/// [`DecodeOptions::with_keep_quantized`] it is only an upper bound: quantized
+/// attributes are still reported as float, so the config gives their data
+/// types, offsets and the buffer size as if they were dequantized.
+///
+/// Probing decodes the whole connectivity, which is a real cost: attribute
+/// values dominate decode time, so it is a fraction of a full decode, but it
+/// is paid again by the decode that follows.
+///
+/// # Arguments
+///
+/// * `data` - The Draco encoded mesh data
+/// * `options` - The vertex layout and attribute filter of the later decode
+///
+/// # Returns
+///
+/// Returns `None` if `data` is not a Draco mesh or the options are invalid.
+///
+/// # Example
+///
+/// ```ignore
+/// use draco_decoder::{DecodeOptions, probe_mesh};
+///
+/// let probe = probe_mesh(data, &DecodeOptions::new()).unwrap();
+/// if probe.config().buffer_size() > budget {
+///     return Err("mesh does not fit");
+/// }
+/// ```
+#[cfg(not(target_arch = "wasm32"))]
+pub fn probe_mesh(data: &[u8], options: &DecodeOptions) -> Option<MeshProbe> {
+    ffi::probe_mesh(data, options)
+}
+
+/// Decodes a Draco compressed mesh synchronously on multiple threads (native only).
+///
+/// Produces the same buffer and config as [`decode_mesh_with_config_sync`], but the
+/// index block and every attribute block are written concurrently on a shared
+/// worker pool. Very large blocks are further split into vertex ranges.
+///
+/// # Arguments
+///
+/// * `data` - The Draco encoded mesh data
+/// * `num_threads` - Maximum number of threads to use, including the calling
+///   thread. `0` uses every available hardware thread.
+///
+/// # Returns
+///
+/// Returns `Ok(MeshDecodeResult)` on success, or the [`DecodeError`] of the
+/// failure.
+#[cfg(not(target_arch = "wasm32"))]
+pub fn decode_mesh_with_config_parallel(
+    data: &[u8],
+    num_threads: usize,
+) -> Result<MeshDecodeResult, DecodeError> {
+    ffi::decode_mesh_with_config_parallel(data, num_threads)
+}
+
+/// Decodes many Draco compressed meshes in one call (native only).
+///
+/// All blobs are decoded on a shared worker pool and written back to back into
+/// a single buffer, which avoids a separate allocation and FFI round trip per
+/// mesh. This suits glTF files with many small `KHR_draco_mesh_compression`
+/// primitives.
+///
+/// # Arguments
+///
+/// * `blobs` - The Draco encoded data of each mesh
+/// * `num_threads` - Maximum number of threads to use, including the calling
+///   thread. `0` uses every available hardware thread.
+///
+/// # Returns
+///
+/// Returns `Ok(BatchDecodeResult)` with one config per input blob, or a
+/// [`BatchDecodeError`] with the index of the first blob that failed and its
+/// [`DecodeError`].
+#[cfg(not(target_arch = "wasm32"))]
+pub fn decode_mesh_batch(
+    blobs: &[&[u8]],
+    num_threads: usize,
+) -> Result<BatchDecodeResult, BatchDecodeError> {
+    ffi::decode_mesh_batch(blobs, num_threads)
+}
+
+/// Decodes a Draco compressed point cloud synchronously (native only).
+///
+/// Every attribute is written into one buffer using the same planar layout as
+/// meshes, without an index block. Use [`DracoPointCloud::chunks`] to stream
+/// large clouds out in fixed-size blocks instead.
+///
+/// # Arguments
+///
+/// * `data` - The Draco encoded point cloud data
+///
+/// # Returns
+///
+/// Returns `Ok(MeshDecodeResult)` on success, or [`DecodeError::Draco`] with the
+/// `draco::Status` if Draco rejects `data`.
+#[cfg(not(target_arch = "wasm32"))]
+pub fn decode_point_cloud_with_config_sync(data: &[u8]) -> Result<MeshDecodeResult, DecodeError> {
+    DracoPointCloud::new(data)?.decode()
+}
+
+/// Decodes a Draco compressed point cloud into spatially chunked output.
+///
+/// Points are grouped by the cells of a grid of `2^depth` cells per axis, in
+/// Morton order of the cells, and the returned chunks give the point range and
+/// bounds of every non-empty cell, as with [`DracoPointCloud::chunk_spatially`].
+/// The buffer has the layout of [`decode_point_cloud_with_config_sync`], so the
+/// points of a chunk are contiguous in every attribute block.
+///
+/// # Returns
+///
+/// Returns the result and the chunks on success, [`DecodeError::Draco`] if Draco
+/// rejects `data`, or [`DecodeError::InvalidOptions`] if the cloud has no 3D
+/// positions or `depth` is above [`DracoPointCloud::MAX_CHUNK_DEPTH`].
+#[cfg(not(target_arch = "wasm32"))]
+pub fn decode_point_cloud_chunked_sync(
+    data: &[u8],
+    depth: u32,
+) -> Result<(MeshDecodeResult, Vec<SpatialChunk>), DecodeError> {
+    let mut cloud = DracoPointCloud::new(data)?;
+    let chunks = cloud
+        .chunk_spatially(depth)
+        .ok_or(DecodeError::InvalidOptions)?;
+    Ok((cloud.decode()?, chunks))
+}
+
 /// Decodes a Draco compressed mesh asynchronously (WASM).
 ///
 /// This function uses a JavaScript Worker to decode the mesh asynchronously
@@ -97,6 +321,35 @@ pub async fn decode_mesh_with_config(data: &[u8]) -> Option<MeshDecodeResult> {
     wasm::decode_mesh_wasm_worker_with_config(data).await
 }
 
+/// Pays the one-time setup cost of the decoder before the first decode.
+///
+/// In the browser this compiles the Draco wasm module, which every decode
+/// worker then instantiates without compiling it again, and starts the first
+/// worker. On native targets it starts the threads of [`DecodePool::global`].
+///
+/// # Returns
+///
+/// Returns `false` if the decoder failed to load.
+#[cfg(not(target_arch = "wasm32"))]
+pub async fn warm_up() -> bool {
+    DecodePool::global();
+    true
+}
+
+/// Pays the one-time setup cost of the decoder before the first decode.
+///
+/// In the browser this compiles the Draco wasm module, which every decode
+/// worker then instantiates without compiling it again, and starts the first
+/// worker. On native targets it starts the threads of the default decode pool.
+///
+/// # Returns
+///
+/// Returns `false` if the decoder failed to load.
+#[cfg(target_arch = "wasm32")]
+pub async fn warm_up() -> bool {
+    wasm::warm_up().await
+}
+
 #[cfg(test)]
 mod tests {
 
@@ -117,7 +370,7 @@ mod tests {
     #[test]
     fn test_decode_point_cloud() {
         let input = fs::read("assets/pointcloud.drc").expect("Failed to read pointcloud.drc");
-        let output = decode_point_cloud_native(&input);
+        let output = decode_point_cloud_native(&input).expect("Decode failed");
 
         assert!(
             output.len().is_multiple_of(12),
@@ -181,6 +434,1100 @@ mod tests {
         }
     }
 
+    #[cfg(not(target_arch = "wasm32"))]
+    #[test]
+    fn test_decode_mesh_index_formats() {
+        use crate::{AttributeDataType, DecodeOptions, IndexFormat, decode_mesh_with_options_sync};
+
+        fn indices(data: &[u8], count: usize, size: usize) -> Vec<u32> {
+            data[..count * size]
+                .chunks_exact(size)
+                .map(|b| b.iter().rev().fold(0, |v, &byte| v << 8 | u32::from(byte)))
+                .collect()
+        }
+
+        for path in ["assets/mesh.drc", "assets/20/20_data.bin"] {
+            let input = fs::read(path).expect("Failed to read model file");
+            let decode = |format| {
+                decode_mesh_with_options_sync(
+                    &input,
+                    &DecodeOptions::new().with_index_format(format),
+                )
+            };
+            let wide = decode(IndexFormat::U32).expect("Decode failed");
+            let count = wide.config.index_count() as usize;
+            let vertex_count = wide.config.vertex_count();
+            assert_eq!(wide.config.index_data_type(), AttributeDataType::UInt32);
+            let expected = indices(&wide.data, count, 4);
+
+            // The width follows the vertex count, not the index count.
+            let auto = if vertex_count <= 1 << 16 {
+                AttributeDataType::UInt16
+            } else {
+                AttributeDataType::UInt32
+            };
+            let smallest = if vertex_count <= 1 << 8 {
+                AttributeDataType::UInt8
+            } else {
+                auto
+            };
+            for (format, data_type) in [
+                (IndexFormat::Auto, auto),
+                (IndexFormat::Smallest, smallest),
+                (IndexFormat::U16, AttributeDataType::UInt16),
+            ] {
+                let result = decode(format).expect("Decode failed");
+                let size = data_type.size_in_bytes();
+                assert_eq!(result.config.index_data_type(), data_type, "{path}");
+                assert_eq!(result.config.index_length() as usize, count * size);
+                assert_eq!(indices(&result.data, count, size), expected);
+                // The planar vertex blocks follow the index block unchanged.
+                assert_eq!(
+                    result.data[count * size..],
+                    wide.data[wide.config.index_length() as usize..]
+                );
+            }
+            assert_eq!(decode(IndexFormat::U8).is_ok(), vertex_count <= 1 << 8);
+        }
+    }
+
+    #[cfg(not(target_arch = "wasm32"))]
+    #[test]
+    fn test_decode_mesh_vertex_cache_optimization() {
+        use crate::{AttributeType, DecodeOptions, IndexFormat, MeshDecodeResult};
+        use crate::{decode_mesh_with_options_sync, utils::AttributeDataType};
+
+        // Triangles as the position bytes of their corners, in winding order.
+        fn triangles(result: &MeshDecodeResult) -> (Vec<u32>, Vec<Vec<u8>>) {
+            let count = result.config.index_count() as usize;
+            let indices: Vec<u32> = result.data[..count * 4]
+                .chunks_exact(4)
+                .map(|b| u32::from_le_bytes(b.try_into().unwrap()))
+                .collect();
+            let position = result
+                .config
+                .attributes()
+                .into_iter()
+                .find(|a| a.attribute_type() == AttributeType::Position)
+                .unwrap();
+            let size =
+                (position.dim() * AttributeDataType::Float32.size_in_bytes() as u32) as usize;
+            let mut corners: Vec<Vec<u8>> = indices
+                .chunks_exact(3)
+                .map(|face| {
+                    face.iter()
+                        .flat_map(|&v| {
+                            let at = position.offset() as usize + v as usize * size;
+                            result.data[at..at + size].to_vec()
+                        })
+                        .collect()
+                })
+                .collect();
+            corners.sort();
+            (indices, corners)
+        }
+
+        // Misses of a 16 entry FIFO cache per triangle.
+        fn acmr(indices: &[u32]) -> f64 {
+            let mut cache = std::collections::VecDeque::new();
+            let mut misses = 0;
+            for &v in indices {
+                if !cache.contains(&v) {
+                    misses += 1;
+                    cache.push_back(v);
+                    if cache.len() > 16 {
+                        cache.pop_front();
+                    }
+                }
+            }
+            misses as f64 / (indices.len() / 3) as f64
+        }
+
+        let input = fs::read("assets/20/20_data.bin").expect("Failed to read model file");
+        let options = DecodeOptions::new().with_index_format(IndexFormat::U32);
+        let plain = decode_mesh_with_options_sync(&input, &options).expect("Decode failed");
+        let optimized = decode_mesh_with_options_sync(
+            &input,
+            &options.clone().with_vertex_cache_optimization(true),
+        )
+        .expect("Decode failed");
+        assert_eq!(optimized.config, plain.config);
+
+        let (plain_indices, plain_triangles) = triangles(&plain);
+        let (indices, optimized_triangles) = triangles(&optimized);
+        assert_eq!(optimized_triangles, plain_triangles);
+        assert!(acmr(&indices) <= acmr(&plain_indices));
+        // Vertices are numbered in order of first use.
+        let mut next = 0;
+        for &v in &indices {
+            assert!(v <= next);
+            next = next.max(v + 1);
+        }
+    }
+
+    #[cfg(not(target_arch = "wasm32"))]
+    #[test]
+    fn test_decode_error_status() {
+        use crate::{DecodeError, StatusCode, decode_mesh_with_config_sync};
+
+        match decode_mesh_with_config_sync(b"not draco") {
+            Err(DecodeError::Draco { code, message }) => {
+                assert_eq!(code, StatusCode::Error);
+                assert!(!message.is_empty());
+            }
+            _ => panic!("Expected a Draco error"),
+        }
+
+        let input = fs::read("assets/20/20_data.bin").expect("Failed to read model file");
+        assert!(matches!(
+            decode_mesh_with_config_sync(&input[..input.len() / 2]),
+            Err(DecodeError::Draco { .. })
+        ));
+    }
+
+    #[cfg(not(target_arch = "wasm32"))]
+    #[test]
+    fn test_decode_mesh_with_config_parallel() {
+        use crate::{decode_mesh_with_config_parallel, decode_mesh_with_config_sync};
+
+        let input = fs::read("assets/20/20_data.bin").expect("Failed to read model file");
+
+        let expected = decode_mesh_with_config_sync(&input).expect("Sequential decode failed");
+        for num_threads in [0, 1, 4] {
+            let actual = decode_mesh_with_config_parallel(&input, num_threads)
+                .expect("Parallel decode failed");
+            assert_eq!(actual.config, expected.config);
+            assert_eq!(actual.data, expected.data);
+        }
+    }
+
+    #[cfg(not(target_arch = "wasm32"))]
+    #[test]
+    fn test_decode_mesh_batch() {
+        use crate::{DecodeError, decode_mesh_batch, decode_mesh_with_config_sync};
+
+        let model = fs::read("assets/20/20_data.bin").expect("Failed to read model file");
+        let mesh = fs::read("assets/mesh.drc").expect("Failed to read mesh.drc");
+        let blobs: [&[u8]; 3] = [&model, &mesh, &model];
+
+        let batch = decode_mesh_batch(&blobs, 0).expect("Batch decode failed");
+        assert_eq!(batch.len(), blobs.len());
+
+        for (i, blob) in blobs.iter().enumerate() {
+            let expected = decode_mesh_with_config_sync(blob).expect("Single decode failed");
+            assert_eq!(batch.offsets[i] % 4, 0);
+            assert_eq!(batch.configs[i], expected.config);
+            assert_eq!(batch.mesh_data(i).unwrap(), &expected.data[..]);
+        }
+
+        let blobs: [&[u8]; 4] = [&model, b"not draco", &mesh, b""];
+        let error = decode_mesh_batch(&blobs, 0).expect_err("Bad blob accepted");
+        assert_eq!(error.index, 1);
+        assert!(matches!(error.error, DecodeError::Draco { .. }));
+    }
+
+    #[cfg(not(target_arch = "wasm32"))]
+    #[test]
+    fn test_decoder_context_reuse() {
+        use crate::{DecoderContext, decode_mesh_with_config_sync};
+
+        let model = fs::read("assets/20/20_data.bin").expect("Failed to read model file");
+        let mesh = fs::read("assets/mesh.drc").expect("Failed to read mesh.drc");
+
+        let mut context = DecoderContext::new();
+        let mut buffer = Vec::new();
+        for blob in [&model, &mesh, &model] {
+            let expected = decode_mesh_with_config_sync(blob).expect("Decode failed");
+            let config = context
+                .decode_mesh_into(blob, &mut buffer)
+                .expect("Context decode failed");
+            assert_eq!(*config, expected.config);
+            assert_eq!(buffer, expected.data);
+        }
+
+        assert!(
+            context
+                .decode_mesh_into(b"not draco", &mut buffer)
+                .is_none()
+        );
+        assert!(buffer.is_empty());
+    }
+
+    #[cfg(not(target_arch = "wasm32"))]
+    #[test]
+    fn test_decoder_context_memory_budget() {
+        use crate::{DecodeError, DecoderContext, OutputAllocator, decode_mesh_with_config_sync};
+
+        // Hands out consecutive slices of a fixed buffer.
+        struct Arena {
+            memory: Vec<u8>,
+            used: usize,
+        }
+        impl OutputAllocator for Arena {
+            fn allocate(&mut self, size: usize) -> Option<&mut [u8]> {
+                let start = self.used;
+                self.used = start.checked_add(size)?;
+                self.memory.get_mut(start..self.used)
+            }
+        }
+
+        let model = fs::read("assets/20/20_data.bin").expect("Failed to read model file");
+        let expected = decode_mesh_with_config_sync(&model).expect("Decode failed");
+        let size = expected.config.buffer_size() as usize;
+
+        let mut context = DecoderContext::new();
+        let mut arena = Arena {
+            memory: vec![0; size + 1],
+            used: 1,
+        };
+        let (config, data) = context
+            .decode_mesh_with(&model, &mut arena)
+            .expect("Context decode failed");
+        assert_eq!(*config, expected.config);
+        assert_eq!(data, &expected.data[..]);
+        assert!(context.heap_bytes() > 0);
+        assert_eq!(
+            context.decode_mesh_with(&model, &mut arena).err(),
+            Some(DecodeError::AllocationFailed)
+        );
+
+        // Draco alone needs more than 1 KiB for the mesh.
+        let mut context = DecoderContext::new().with_memory_budget(1024);
+        let mut buffer = Vec::new();
+        assert_eq!(
+            context.decode_mesh_with(&model, &mut buffer).err(),
+            Some(DecodeError::OverBudget)
+        );
+        assert!(context.decode_mesh_into(&model, &mut buffer).is_none());
+        assert!(matches!(
+            context.decode_mesh_with(b"not draco", &mut buffer),
+            Err(DecodeError::Draco { .. })
+        ));
+
+        let mut context = DecoderContext::new().with_memory_budget(64 << 20);
+        let (_, data) = context
+            .decode_mesh_with(&model, &mut buffer)
+            .expect("Context decode failed");
+        assert_eq!(data, &expected.data[..]);
+    }
+
+    #[cfg(not(target_arch = "wasm32"))]
+    #[test]
+    fn test_decode_point_cloud_chunks() {
+        use crate::{AttributeType, DracoPointCloud, decode_point_cloud_with_config_sync};
+
+        let input = fs::read("assets/pointcloud.drc").expect("Failed to read pointcloud.drc");
+        let full = decode_point_cloud_with_config_sync(&input).expect("Decode failed");
+        assert_eq!(full.config.index_count(), 0);
+        assert_eq!(full.data.len(), full.config.buffer_size());
+        assert!(
+            full.config
+                .attributes()
+                .iter()
+                .any(|a| a.attribute_type() == AttributeType::Position)
+        );
+
+        // Re-assemble each attribute block from 2-point chunks.
+        let cloud = DracoPointCloud::new(&input).expect("Decode failed");
+        let mut blocks = vec![Vec::new(); full.config.attributes().len()];
+        let mut points = 0;
+        for chunk in cloud.chunks(2) {
+            points += chunk.config.vertex_count();
+            for (block, attr) in blocks.iter_mut().zip(chunk.config.attributes()) {
+                let start = attr.offset() as usize;
+                block.extend_from_slice(&chunk.data[start..start + attr.lenght() as usize]);
+            }
+        }
+        assert_eq!(points, full.config.vertex_count());
+        for (block, attr) in blocks.iter().zip(full.config.attributes()) {
+            let start = attr.offset() as usize;
+            assert_eq!(
+                &block[..],
+                &full.data[start..start + attr.lenght() as usize]
+            );
+        }
+    }
+
+    #[cfg(not(target_arch = "wasm32"))]
+    #[test]
+    fn test_decode_point_cloud_spatially_chunked() {
+        use crate::{
+            AttributeDataType, AttributeType, decode_point_cloud_chunked_sync,
+            decode_point_cloud_with_config_sync,
+        };
+
+        let input = fs::read("assets/pointcloud.drc").expect("Failed to read pointcloud.drc");
+        let positions = |result: &crate::MeshDecodeResult| -> Vec<[f32; 3]> {
+            let attr = result
+                .config
+                .attributes()
+                .into_iter()
+                .find(|a| a.attribute_type() == AttributeType::Position)
+                .expect("No positions");
+            assert_eq!(attr.data_type(), AttributeDataType::Float32);
+            let start = attr.offset() as usize;
+            result.data[start..start + attr.lenght() as usize]
+                .chunks_exact(12)
+                .map(|v| {
+                    std::array::from_fn(|c| {
+                        f32::from_le_bytes(v[c * 4..c * 4 + 4].try_into().unwrap())
+                    })
+                })
+                .collect()
+        };
+
+        let full = decode_point_cloud_with_config_sync(&input).expect("Decode failed");
+        let (chunked, chunks) = decode_point_cloud_chunked_sync(&input, 2).expect("Decode failed");
+        assert_eq!(chunked.config, full.config);
+
+        // Chunks tile the cloud in increasing cell order, and bound their points.
+        let points = positions(&chunked);
+        let mut next = 0;
+        for (i, chunk) in chunks.iter().enumerate() {
+            assert_eq!(chunk.first_point, next);
+            assert!(chunk.num_points > 0 && chunk.cell < 1 << 6);
+            assert!(i == 0 || chunks[i - 1].cell < chunk.cell);
+            let range = next as usize..(next + chunk.num_points) as usize;
+            for point in &points[range] {
+                for (c, &value) in point.iter().enumerate() {
+                    assert!(chunk.min[c] <= value && value <= chunk.max[c]);
+                }
+            }
+            next += chunk.num_points;
+        }
+        assert_eq!(next, full.config.vertex_count());
+
+        // Same points, only reordered.
+        let key = |p: &[f32; 3]| p.map(f32::to_bits);
+        let mut expected: Vec<_> = positions(&full).iter().map(key).collect();
+        let mut actual: Vec<_> = points.iter().map(key).collect();
+        expected.sort_unstable();
+        actual.sort_unstable();
+        assert_eq!(actual, expected);
+
+        let too_deep = crate::DracoPointCloud::MAX_CHUNK_DEPTH + 1;
+        assert!(matches!(
+            decode_point_cloud_chunked_sync(&input, too_deep),
+            Err(crate::DecodeError::InvalidOptions)
+        ));
+    }
+
+    #[cfg(not(target_arch = "wasm32"))]
+    #[test]
+    fn test_draco_mesh_decode_into_slice() {
+        use crate::{DracoMesh, decode_mesh_with_config_sync};
+
+        let input = fs::read("assets/20/20_data.bin").expect("Failed to read model file");
+        let expected = decode_mesh_with_config_sync(&input).expect("Decode failed");
+
+        let mesh = DracoMesh::new(&input).expect("Decode failed");
+        assert_eq!(*mesh.config(), expected.config);
+
+        let size = mesh.config().buffer_size();
+        let mut staging = vec![0xAAu8; size + 16];
+        assert_eq!(mesh.decode_into(&mut staging), Some(size));
+        assert_eq!(&staging[..size], &expected.data[..]);
+        assert!(staging[size..].iter().all(|&b| b == 0xAA));
+
+        assert_eq!(mesh.decode_into(&mut staging[..size - 1]), None);
+    }
+
+    #[cfg(not(target_arch = "wasm32"))]
+    #[test]
+    fn test_draco_mesh_consume() {
+        use crate::{DecodeOptions, DracoMesh, VertexLayout};
+
+        let input = fs::read("assets/20/20_data.bin").expect("Failed to read model file");
+        let interleaved = DecodeOptions::new()
+            .with_layout(VertexLayout::Interleaved)
+            .with_alignment(4);
+        for options in [DecodeOptions::new(), interleaved] {
+            // Written without consuming, so the comparison does not rely on it.
+            let expected = DracoMesh::with_options(&input, &options)
+                .and_then(|mesh| mesh.decode())
+                .expect("Decode failed");
+
+            let mesh = DracoMesh::with_options(&input, &options).expect("Decode failed");
+            let result = mesh.into_decoded().expect("Consuming decode failed");
+            assert_eq!(result.config, expected.config);
+            assert_eq!(result.data, expected.data);
+
+            let mesh = DracoMesh::with_options(&input, &options).expect("Decode failed");
+            let size = mesh.config().buffer_size();
+            let mut staging = vec![0xAAu8; size + 16];
+            assert_eq!(mesh.consume_into(&mut staging), Some(size));
+            assert_eq!(&staging[..size], &expected.data[..]);
+            assert!(staging[size..].iter().all(|&b| b == 0xAA));
+        }
+    }
+
+    #[cfg(not(target_arch = "wasm32"))]
+    #[test]
+    fn test_draco_mesh_set_options_replans() {
+        use crate::{
+            DecodeOptions, DracoMesh, VertexLayout, decode_mesh_with_config_sync,
+            decode_mesh_with_options_sync,
+        };
+
+        let input = fs::read("assets/20/20_data.bin").expect("Failed to read model file");
+        let planar = decode_mesh_with_config_sync(&input).expect("Decode failed");
+        let options = DecodeOptions::new()
+            .with_layout(VertexLayout::Interleaved)
+            .with_alignment(4);
+        let interleaved = decode_mesh_with_options_sync(&input, &options).expect("Decode failed");
+
+        let mut mesh = DracoMesh::new(&input).expect("Decode failed");
+        assert!(mesh.set_options(&options));
+        assert_eq!(mesh.decode().unwrap().data, interleaved.data);
+
+        // Invalid options keep the current plan.
+        assert!(!mesh.set_options(&DecodeOptions::new().with_alignment(3)));
+        assert_eq!(*mesh.config(), interleaved.config);
+        let mut out = vec![0u8; mesh.config().buffer_size()];
+        mesh.decode_into_parallel(&mut out, 2)
+            .expect("Decode failed");
+        assert_eq!(out, interleaved.data);
+
+        assert!(mesh.set_options(&DecodeOptions::new()));
+        assert_eq!(mesh.decode().unwrap().data, planar.data);
+    }
+
+    #[cfg(not(target_arch = "wasm32"))]
+    #[test]
+    fn test_decode_mesh_with_interleaved_layout() {
+        use crate::{
+            DecodeError, DecodeOptions, DracoMesh, VertexLayout, decode_mesh_with_config_sync,
+            decode_mesh_with_options_sync,
+        };
+
+        let input = fs::read("assets/20/20_data.bin").expect("Failed to read model file");
+        let planar = decode_mesh_with_config_sync(&input).expect("Decode failed");
+        let vertex_count = planar.config.vertex_count() as usize;
+        let index_length = planar.config.index_length() as usize;
+
+        let options = DecodeOptions::new()
+            .with_layout(VertexLayout::Interleaved)
+            .with_alignment(4);
+        let interleaved = decode_mesh_with_options_sync(&input, &options).expect("Decode failed");
+        assert_eq!(interleaved.data.len(), interleaved.config.buffer_size());
+        assert_eq!(
+            interleaved.data[..index_length],
+            planar.data[..index_length]
+        );
+
+        // Every attribute shares one stride and matches its planar values.
+        let attributes = interleaved.config.attributes();
+        let stride = attributes[0].byte_stride() as usize;
+        for (attr, expected) in attributes.iter().zip(planar.config.attributes()) {
+            assert_eq!(attr.byte_stride() as usize, stride);
+            assert_eq!(attr.offset() % 4, 0);
+            let value_size = (attr.dim() * attr.data_type().size_in_bytes() as u32) as usize;
+            for v in 0..vertex_count {
+                let actual = attr.offset() as usize + v * stride;
+                let planar_start = expected.offset() as usize + v * value_size;
+                assert_eq!(
+                    interleaved.data[actual..actual + value_size],
+                    planar.data[planar_start..planar_start + value_size]
+                );
+            }
+        }
+
+        // The parallel writer produces the same bytes.
+        let mesh = DracoMesh::with_options(&input, &options).expect("Decode failed");
+        let mut out = vec![0xAAu8; mesh.config().buffer_size()];
+        mesh.decode_into_parallel(&mut out, 4)
+            .expect("Decode failed");
+        assert_eq!(out, interleaved.data);
+
+        // Grouped layouts keep unlisted attributes planar after the groups.
+        let ids: Vec<u32> = attributes.iter().map(|a| a.unique_id()).collect();
+        let options =
+            DecodeOptions::new().with_layout(VertexLayout::Grouped(vec![vec![ids[1], ids[0]]]));
+        let grouped = decode_mesh_with_options_sync(&input, &options).expect("Decode failed");
+        let grouped_attrs = grouped.config.attributes();
+        assert_eq!(grouped_attrs[1].offset() as usize, index_length);
+        assert_eq!(
+            grouped_attrs[0].byte_stride(),
+            grouped_attrs[1].byte_stride()
+        );
+        assert_eq!(
+            grouped_attrs[2].byte_stride(),
+            grouped_attrs[2].dim() * grouped_attrs[2].data_type().size_in_bytes() as u32
+        );
+
+        let invalid = DecodeOptions::new().with_alignment(3);
+        assert_eq!(
+            DracoMesh::with_options(&input, &invalid).err(),
+            Some(DecodeError::InvalidOptions)
+        );
+    }
+
+    #[cfg(not(target_arch = "wasm32"))]
+    #[test]
+    fn test_decode_mesh_attribute_filter() {
+        use crate::{
+            AttributeType, DecodeOptions, decode_mesh_with_config_sync,
+            decode_mesh_with_options_sync,
+        };
+
+        let input = fs::read("assets/20/20_data.bin").expect("Failed to read model file");
+        let full = decode_mesh_with_config_sync(&input).expect("Decode failed");
+        let index_length = full.config.index_length() as usize;
+        let attributes = full.config.attributes();
+        let position = attributes
+            .iter()
+            .find(|a| a.attribute_type() == AttributeType::Position)
+            .expect("No position attribute");
+        let position_range =
+            position.offset() as usize..(position.offset() + position.lenght()) as usize;
+
+        // Positions and indices only.
+        let options = DecodeOptions::new().with_attribute_types(&[AttributeType::Position]);
+        let result = decode_mesh_with_options_sync(&input, &options).expect("Decode failed");
+        let selected = result.config.attributes();
+        assert_eq!(selected.len(), 1);
+        assert_eq!(selected[0].unique_id(), position.unique_id());
+        assert_eq!(selected[0].offset() as usize, index_length);
+        assert_eq!(result.data[..index_length], full.data[..index_length]);
+        assert_eq!(result.data[index_length..], full.data[position_range]);
+
+        // The same selection by unique id, plus one more attribute.
+        let other = attributes
+            .iter()
+            .find(|a| a.unique_id() != position.unique_id())
+            .unwrap();
+        let options =
+            DecodeOptions::new().with_attribute_ids(&[position.unique_id(), other.unique_id()]);
+        let result = decode_mesh_with_options_sync(&input, &options).expect("Decode failed");
+        let mut ids: Vec<u32> = result
+            .config
+            .attributes()
+            .iter()
+            .map(|a| a.unique_id())
+            .collect();
+        ids.sort();
+        let mut expected = vec![position.unique_id(), other.unique_id()];
+        expected.sort();
+        assert_eq!(ids, expected);
+    }
+
+    #[cfg(not(target_arch = "wasm32"))]
+    #[test]
+    fn test_attribute_filter_skips_transforms() {
+        use super::ffi::skipped_transform_types;
+        use crate::{AttributeType, DecodeOptions};
+
+        // A type filter skips the transforms of every other type.
+        let options = DecodeOptions::new().with_attribute_types(&[AttributeType::Position]);
+        let skipped = skipped_transform_types(&options);
+        assert!(!skipped.contains(&AttributeType::Position));
+        for other in [
+            AttributeType::Normal,
+            AttributeType::Color,
+            AttributeType::TexCoord,
+            AttributeType::Generic,
+        ] {
+            assert!(skipped.contains(&other), "{other:?} transform not skipped");
+        }
+
+        // Ids may select any type, so id and mixed filters skip nothing.
+        let options = DecodeOptions::new().with_attribute_ids(&[0]);
+        assert!(skipped_transform_types(&options).is_empty());
+        let options = options.with_attribute_types(&[AttributeType::Position]);
+        assert!(skipped_transform_types(&options).is_empty());
+        assert!(skipped_transform_types(&DecodeOptions::new()).is_empty());
+    }
+
+    #[cfg(not(target_arch = "wasm32"))]
+    #[test]
+    fn test_decode_mesh_keep_quantized() {
+        use crate::{
+            AttributeDataType, AttributeType, DecodeOptions, decode_mesh_with_config_sync,
+            decode_mesh_with_options_sync,
+        };
+
+        let input = fs::read("assets/20/20_data.bin").expect("Failed to read model file");
+        let full = decode_mesh_with_config_sync(&input).expect("Decode failed");
+        let options = DecodeOptions::new().with_keep_quantized(true);
+        let result = decode_mesh_with_options_sync(&input, &options).expect("Decode failed");
+        assert!(result.data.len() <= full.data.len());
+
+        for (attr, expected) in result
+            .config
+            .attributes()
+            .iter()
+            .zip(full.config.attributes())
+        {
+            assert_eq!(attr.unique_id(), expected.unique_id());
+            let Some(quantization) = attr.quantization() else {
+                assert_eq!(attr.data_type(), expected.data_type());
+                continue;
+            };
+            assert_ne!(attr.attribute_type(), AttributeType::Normal);
+            assert_eq!(expected.data_type(), AttributeDataType::Float32);
+            assert_eq!(quantization.origin().len(), attr.dim() as usize);
+
+            // Dequantizing on the CPU reproduces the float values.
+            let dim = attr.dim() as usize;
+            let size = attr.data_type().size_in_bytes();
+            for v in 0..result.config.vertex_count() as usize {
+                for c in 0..dim {
+                    let at = attr.offset() as usize + v * attr.byte_stride() as usize + c * size;
+                    let q = match attr.data_type() {
+                        AttributeDataType::UInt8 => result.data[at] as f32,
+                        AttributeDataType::UInt16 => {
+                            u16::from_le_bytes([result.data[at], result.data[at + 1]]) as f32
+                        }
+                        _ => u32::from_le_bytes(result.data[at..at + 4].try_into().unwrap()) as f32,
+                    };
+                    let at = expected.offset() as usize + (v * dim + c) * 4;
+                    let value = f32::from_le_bytes(full.data[at..at + 4].try_into().unwrap());
+                    let dequantized = quantization.origin()[c] + q * quantization.step();
+                    assert!((dequantized - value).abs() <= quantization.step());
+                }
+            }
+        }
+    }
+
+    #[cfg(not(target_arch = "wasm32"))]
+    #[test]
+    fn test_decode_mesh_octahedral_normals() {
+        use crate::{
+            AttributeDataType, AttributeType, DecodeOptions, NormalFormat,
+            decode_mesh_with_config_sync, decode_mesh_with_options_sync,
+        };
+
+        let input = fs::read("assets/20/20_data.bin").expect("Failed to read model file");
+        let full = decode_mesh_with_config_sync(&input).expect("Decode failed");
+        let options = DecodeOptions::new().with_normal_format(NormalFormat::Oct16);
+        let result = decode_mesh_with_options_sync(&input, &options).expect("Decode failed");
+
+        let find = |config: &crate::DracoDecodeConfig| {
+            *config
+                .attributes()
+                .iter()
+                .find(|attr| attr.attribute_type() == AttributeType::Normal)
+                .expect("No normal attribute")
+        };
+        let (packed, expected) = (find(&result.config), find(&full.config));
+        assert_eq!(packed.dim(), 2);
+        assert_eq!(packed.data_type(), AttributeDataType::Int16);
+        assert_eq!(packed.byte_stride(), 4);
+
+        let read_i16 =
+            |at: usize| i16::from_le_bytes([result.data[at], result.data[at + 1]]) as f32 / 32767.0;
+        let read_f32 = |at: usize| f32::from_le_bytes(full.data[at..at + 4].try_into().unwrap());
+        for v in 0..result.config.vertex_count() as usize {
+            // Unpack like a vertex shader would.
+            let at = packed.offset() as usize + v * 4;
+            let (mut x, mut y) = (read_i16(at), read_i16(at + 2));
+            let z = 1.0 - x.abs() - y.abs();
+            if z < 0.0 {
+                (x, y) = ((1.0 - y.abs()) * x.signum(), (1.0 - x.abs()) * y.signum());
+            }
+            let at = expected.offset() as usize + v * 12;
+            let n = [read_f32(at), read_f32(at + 4), read_f32(at + 8)];
+            let len = (x * x + y * y + z * z).sqrt();
+            let n_len = (n[0] * n[0] + n[1] * n[1] + n[2] * n[2]).sqrt();
+            if n_len == 0.0 {
+                continue;
+            }
+            let cos = (x * n[0] + y * n[1] + z * n[2]) / (len * n_len);
+            assert!(cos > 0.999, "vertex {v}: {cos}");
+        }
+    }
+
+    #[cfg(not(target_arch = "wasm32"))]
+    #[test]
+    fn test_decode_mesh_from_file() {
+        use crate::{DracoFile, decode_mesh_from_path, decode_mesh_with_config_sync};
+
+        let drc = fs::read("assets/mesh.drc").expect("Failed to read model file");
+        let expected = decode_mesh_with_config_sync(&drc).expect("Decode failed");
+        let result = decode_mesh_from_path("assets/mesh.drc").expect("Decode failed");
+        assert_eq!(result.data, expected.data);
+        assert_eq!(result.config, expected.config);
+
+        // Pack the glTF and its buffer into a .glb.
+        let mut gltf: serde_json::Value =
+            serde_json::from_slice(&fs::read("assets/20/20.gltf").unwrap()).unwrap();
+        gltf["buffers"][0].as_object_mut().unwrap().remove("uri");
+        let mut json = serde_json::to_vec(&gltf).unwrap();
+        json.resize(json.len().next_multiple_of(4), b' ');
+        let mut bin = fs::read("assets/20/20_data.bin").unwrap();
+        bin.resize(bin.len().next_multiple_of(4), 0);
+        let mut glb = Vec::new();
+        glb.extend_from_slice(b"glTF");
+        glb.extend_from_slice(&2u32.to_le_bytes());
+        glb.extend_from_slice(&((12 + 8 + json.len() + 8 + bin.len()) as u32).to_le_bytes());
+        glb.extend_from_slice(&(json.len() as u32).to_le_bytes());
+        glb.extend_from_slice(b"JSON");
+        glb.extend_from_slice(&json);
+        glb.extend_from_slice(&(bin.len() as u32).to_le_bytes());
+        glb.extend_from_slice(b"BIN\0");
+        glb.extend_from_slice(&bin);
+        let path = std::env::temp_dir().join(format!("draco_decoder_{}.glb", std::process::id()));
+        fs::write(&path, &glb).unwrap();
+
+        let file = DracoFile::open(&path).expect("Failed to open glb");
+        fs::remove_file(&path).ok();
+        assert_eq!(file.primitives().len(), 1);
+        let primitive = &file.primitives()[0];
+        assert!(
+            primitive
+                .attributes()
+                .contains(&("POSITION".to_string(), 1))
+        );
+        let view = &gltf["bufferViews"][0];
+        let offset = view["byteOffset"].as_u64().unwrap_or(0) as usize;
+        let length = view["byteLength"].as_u64().unwrap() as usize;
+        assert_eq!(file.data(primitive), &bin[offset..offset + length]);
+
+        let expected = decode_mesh_with_config_sync(&bin[offset..offset + length]).unwrap();
+        let result = file.decode(primitive).expect("Decode failed");
+        assert_eq!(result.data, expected.data);
+    }
+
+    #[cfg(not(target_arch = "wasm32"))]
+    #[test]
+    fn test_draco_file_rejects_bad_buffer_views() {
+        use crate::DracoFile;
+
+        let bin = std::path::absolute("assets/20/20_data.bin").unwrap();
+        let base: serde_json::Value =
+            serde_json::from_slice(&fs::read("assets/20/20.gltf").unwrap()).unwrap();
+        let path = std::env::temp_dir().join(format!("draco_decoder_{}.gltf", std::process::id()));
+        let open = |edit: &dyn Fn(&mut serde_json::Value)| {
+            let mut gltf = base.clone();
+            gltf["buffers"][0]["uri"] = bin.to_str().unwrap().into();
+            edit(&mut gltf);
+            fs::write(&path, serde_json::to_vec(&gltf).unwrap()).unwrap();
+            DracoFile::open(&path).map(|file| file.primitives().len())
+        };
+
+        assert_eq!(open(&|_| {}).unwrap(), 1);
+        let view = base["meshes"][0]["primitives"][0]["extensions"]["KHR_draco_mesh_compression"]
+            ["bufferView"]
+            .as_u64()
+            .unwrap() as usize;
+        let edits: [&dyn Fn(&mut serde_json::Value); 4] = [
+            // A buffer index far past the buffers must not be allocated for.
+            &|gltf| gltf["bufferViews"][view]["buffer"] = 4_000_000_000u64.into(),
+            &|gltf| gltf["bufferViews"][view]["byteOffset"] = (1u64 << 20).into(),
+            &|gltf| gltf["bufferViews"][view]["byteLength"] = u64::MAX.into(),
+            &|gltf| gltf["buffers"][0]["byteLength"] = 16.into(),
+        ];
+        for edit in edits {
+            let error = open(edit).expect_err("Bad buffer view accepted");
+            assert_eq!(error.kind(), std::io::ErrorKind::InvalidData);
+        }
+        fs::remove_file(&path).ok();
+    }
+
+    #[cfg(not(target_arch = "wasm32"))]
+    #[tokio::test]
+    async fn test_decode_scene_stream() {
+        use crate::{DecodeOptions, DecodePool, DracoFile, decode_mesh_with_config_sync};
+        use std::sync::Arc;
+
+        let big = fs::read("assets/20/20_data.bin").expect("Failed to read model file");
+        let small = fs::read("assets/mesh.drc").expect("Failed to read model file");
+        let file = Arc::new(DracoFile::open("assets/20/20.gltf").expect("Failed to open gltf"));
+        assert_eq!(file.primitives().len(), 1);
+        assert_eq!(file.data(&file.primitives()[0]), &big[..]);
+
+        // Mesh 0 in the big buffer, mesh 1 in the small one, mesh 2 uncompressed.
+        let dir = std::env::temp_dir().join(format!("draco_decoder_{}", std::process::id()));
+        fs::create_dir_all(&dir).unwrap();
+        fs::write(dir.join("big.bin"), &big).unwrap();
+        fs::write(dir.join("small.bin"), &small).unwrap();
+        let draco = |view: u32| {
+            serde_json::json!({ "primitives": [{ "attributes": {}, "extensions": {
+                "KHR_draco_mesh_compression": { "bufferView": view, "attributes": {} }
+            }}]})
+        };
+        let gltf = serde_json::json!({
+            "buffers": [
+                { "uri": "big.bin", "byteLength": big.len() },
+                { "uri": "small.bin", "byteLength": small.len() },
+            ],
+            "bufferViews": [
+                { "buffer": 0, "byteLength": big.len() },
+                { "buffer": 1, "byteLength": small.len() },
+            ],
+            "meshes": [draco(0), draco(1), { "primitives": [{ "attributes": {} }] }],
+        });
+        let path = dir.join("scene.gltf");
+        fs::write(&path, serde_json::to_vec(&gltf).unwrap()).unwrap();
+        let scene = Arc::new(DracoFile::open(&path).expect("Failed to open gltf"));
+        fs::remove_dir_all(&dir).ok();
+        assert_eq!(scene.primitives().len(), 2);
+
+        // One thread decodes in submission order: the smallest first.
+        let pool = DecodePool::new(1);
+        let mut stream = scene.clone().decode_stream(&pool, &DecodeOptions::new());
+        assert_eq!(stream.remaining(), 2);
+        let mut meshes = Vec::new();
+        while let Some((primitive, result)) = stream.next_decoded().await {
+            let input = if primitive.mesh_index() == 0 {
+                &big
+            } else {
+                &small
+            };
+            let expected = decode_mesh_with_config_sync(input).unwrap();
+            assert_eq!(result.expect("Decode failed").data, expected.data);
+            meshes.push(primitive.mesh_index());
+        }
+        assert_eq!(meshes, [1, 0]);
+
+        let meshes: Vec<usize> = scene
+            .decode_stream_by_key(&pool, &DecodeOptions::new(), |p| p.mesh_index())
+            .map(|(primitive, _)| primitive.mesh_index())
+            .collect();
+        assert_eq!(meshes, [0, 1]);
+    }
+
+    #[cfg(not(target_arch = "wasm32"))]
+    #[test]
+    fn test_probe_mesh() {
+        use crate::{DecodeOptions, VertexLayout, decode_mesh_with_options_sync, probe_mesh};
+
+        let options = DecodeOptions::new()
+            .with_layout(VertexLayout::Interleaved)
+            .with_alignment(4);
+        for path in ["assets/mesh.drc", "assets/20/20_data.bin"] {
+            let input = fs::read(path).expect("Failed to read model file");
+            let probe = probe_mesh(&input, &options).expect("Probe failed");
+            let result = decode_mesh_with_options_sync(&input, &options).expect("Decode failed");
+            assert_eq!(probe.config(), &result.config, "{path}");
+            assert_eq!(probe.version().0, 2);
+
+            // Quantized attributes are probed as float, an upper bound.
+            let options = options.clone().with_keep_quantized(true);
+            let probe = probe_mesh(&input, &options).expect("Probe failed");
+            let result = decode_mesh_with_options_sync(&input, &options).expect("Decode failed");
+            assert!(
+                probe.config().buffer_size() >= result.config.buffer_size(),
+                "{path}"
+            );
+            assert_eq!(probe.config().vertex_count(), result.config.vertex_count());
+            assert_eq!(probe.config().index_count(), result.config.index_count());
+        }
+
+        let point_cloud = fs::read("assets/pointcloud.drc").expect("Failed to read model file");
+        assert!(probe_mesh(&point_cloud, &DecodeOptions::new()).is_none());
+        assert!(probe_mesh(b"not draco", &DecodeOptions::new()).is_none());
+    }
+
+    #[cfg(not(target_arch = "wasm32"))]
+    #[tokio::test]
+    async fn test_decode_pool() {
+        use crate::{DecodePool, PoolError, decode_mesh_with_config_sync};
+        use std::sync::mpsc;
+
+        let input = fs::read("assets/mesh.drc").expect("Failed to read model file");
+        let expected = decode_mesh_with_config_sync(&input).expect("Decode failed");
+        let pool = DecodePool::new(1).with_queue_limit(1);
+        let result = pool.decode(input.clone()).await.expect("Decode failed");
+        assert_eq!(result.data, expected.data);
+        assert_eq!(
+            pool.spawn(|| None::<()>).await,
+            Err(PoolError::DecodeFailed)
+        );
+
+        // Hold the only thread so later tasks stay queued.
+        let (release, blocked) = mpsc::channel::<()>();
+        let (started, running) = mpsc::channel();
+        let busy = pool.spawn(move || {
+            started.send(()).unwrap();
+            blocked.recv().ok()
+        });
+        running.recv().unwrap();
+        let queued = pool.decode(input.clone());
+        assert_eq!(pool.queued(), 1);
+        assert_eq!(
+            pool.decode(input.clone()).await.err(),
+            Some(PoolError::QueueFull)
+        );
+
+        queued.cancel();
+        assert_eq!(pool.queued(), 0);
+        assert_eq!(queued.await.err(), Some(PoolError::Cancelled));
+        drop(pool.decode(input.clone()));
+        assert_eq!(pool.queued(), 0);
+
+        release.send(()).unwrap();
+        assert_eq!(busy.await, Ok(()));
+    }
+
+    #[cfg(not(target_arch = "wasm32"))]
+    #[test]
+    fn test_decode_cache() {
+        use crate::{CacheStats, DecodeCache, DecodeOptions, VertexLayout};
+        use crate::{decode_mesh_with_config_sync, decode_mesh_with_options_sync};
+        use std::sync::Arc;
+
+        let mesh = fs::read("assets/mesh.drc").expect("Failed to read model file");
+        let other = fs::read("assets/20/20_data.bin").expect("Failed to read model file");
+        let expected = decode_mesh_with_config_sync(&mesh).expect("Decode failed");
+        let cache = DecodeCache::with_shards(1 << 30, 1);
+
+        let first = cache.decode(&mesh).expect("Decode failed");
+        assert_eq!(first.data, expected.data);
+        assert!(Arc::ptr_eq(&first, &cache.decode(&mesh).unwrap()));
+        assert!(cache.get(&mesh, None).is_some());
+
+        let options = DecodeOptions::new().with_layout(VertexLayout::Interleaved);
+        let interleaved = cache.decode_with_options(&mesh, &options).unwrap();
+        assert_eq!(
+            interleaved.data,
+            decode_mesh_with_options_sync(&mesh, &options).unwrap().data
+        );
+        assert!(cache.decode(b"not draco").is_none());
+        assert_eq!(
+            cache.stats(),
+            CacheStats {
+                hits: 2,
+                misses: 3,
+                evictions: 0,
+                entries: 2,
+                bytes: first.data.len() + interleaved.data.len(),
+            }
+        );
+
+        // Room for one of the two meshes only.
+        let size = decode_mesh_with_config_sync(&other).unwrap().data.len();
+        let small = DecodeCache::with_shards(size.max(first.data.len()), 1);
+        small.decode(&mesh).unwrap();
+        small.decode(&other).unwrap();
+        let stats = small.stats();
+        assert_eq!((stats.entries, stats.evictions), (1, 1));
+        assert!(small.get(&mesh, None).is_none());
+
+        cache.clear();
+        assert_eq!(cache.stats().entries, 0);
+    }
+
+    #[cfg(not(target_arch = "wasm32"))]
+    #[test]
+    fn test_decode_cache_large_results() {
+        use crate::{DecodeCache, DracoDecodeConfig, MeshDecodeResult};
+
+        // Far more than one shard's share of the capacity.
+        let size = 8 << 20;
+        let decode = |fill: u8| {
+            move || {
+                Some(MeshDecodeResult {
+                    data: vec![fill; size],
+                    config: DracoDecodeConfig::new(0, 0, size),
+                })
+            }
+        };
+        let cache = DecodeCache::new(2 * size);
+        cache.get_or_decode(b"first", None, decode(1)).unwrap();
+        cache.get_or_decode(b"second", None, decode(2)).unwrap();
+        let stats = cache.stats();
+        assert_eq!(
+            (stats.entries, stats.bytes, stats.evictions),
+            (2, 2 * size, 0)
+        );
+        assert_eq!(cache.get(b"first", None).unwrap().data[0], 1);
+
+        // Room is made in whichever shards hold the older entries.
+        cache.get_or_decode(b"third", None, decode(3)).unwrap();
+        let stats = cache.stats();
+        assert_eq!(
+            (stats.entries, stats.bytes, stats.evictions),
+            (2, 2 * size, 1)
+        );
+        assert_eq!(cache.get(b"third", None).unwrap().data[0], 3);
+
+        // Too large for the whole cache.
+        let small = DecodeCache::new(size - 1);
+        assert!(small.get_or_decode(b"first", None, decode(1)).is_some());
+        assert_eq!(small.stats().entries, 0);
+
+        cache.clear();
+        assert_eq!(cache.stats().bytes, 0);
+    }
+
+    #[cfg(not(target_arch = "wasm32"))]
+    #[test]
+    fn test_decode_cache_concurrent_capacity() {
+        use crate::{DecodeCache, DracoDecodeConfig, MeshDecodeResult};
+        use std::sync::atomic::{AtomicBool, Ordering};
+
+        let capacity = 64 << 10;
+        let cache = DecodeCache::with_shards(capacity, 2);
+        let done = AtomicBool::new(false);
+        std::thread::scope(|scope| {
+            // Samples the shared reservation while the inserts race.
+            let watcher = scope.spawn(|| {
+                while !done.load(Ordering::Relaxed) {
+                    assert!(cache.reserved_bytes() <= capacity);
+                }
+            });
+            let writers: Vec<_> = (0..8u32)
+                .map(|thread| {
+                    let cache = &cache;
+                    scope.spawn(move || {
+                        for i in 0..5000u32 {
+                            let key = (thread * 10_000 + i).to_le_bytes();
+                            let size = (8 << 10) + (i as usize * 7919) % (32 << 10);
+                            cache.get_or_decode(&key, None, || {
+                                Some(MeshDecodeResult {
+                                    data: vec![0; size],
+                                    config: DracoDecodeConfig::new(0, 0, size),
+                                })
+                            });
+                        }
+                    })
+                })
+                .collect();
+            let joined: Vec<_> = writers.into_iter().map(|writer| writer.join()).collect();
+            done.store(true, Ordering::Relaxed);
+            watcher.join().unwrap();
+            joined.into_iter().for_each(|writer| writer.unwrap());
+        });
+
+        let stats = cache.stats();
+        assert!(stats.bytes <= capacity, "{} > {capacity}", stats.bytes);
+        assert_eq!(stats.bytes, cache.reserved_bytes());
+        assert!(stats.evictions > 0);
+    }
+
+    #[cfg(all(not(target_arch = "wasm32"), feature = "perf"))]
+    #[test]
+    fn test_decode_mesh_with_stats() {
+        use crate::{decode_mesh_with_config_sync, decode_mesh_with_stats_sync};
+
+        let input = fs::read("assets/20/20_data.bin").expect("Failed to read model file");
+        let expected = decode_mesh_with_config_sync(&input).expect("Decode failed");
+
+        let (result, stats) = decode_mesh_with_stats_sync(&input).expect("Decode failed");
+        assert_eq!(result.config, expected.config);
+        assert_eq!(result.data, expected.data);
+        assert_eq!(stats.bytes_in, input.len());
+        assert_eq!(stats.bytes_out, result.data.len());
+        assert!(stats.parse_ns > 0);
+        assert!(stats.allocations > 0);
+        let ids: Vec<u32> = result
+            .config
+            .attributes()
+            .iter()
+            .map(|a| a.unique_id())
+            .collect();
+        let timed: Vec<u32> = stats.attribute_write_ns.iter().map(|&(id, _)| id).collect();
+        assert_eq!(timed, ids);
+    }
+
+    #[cfg(target_arch = "wasm32")]
+    #[wasm_bindgen_test]
+    async fn test_warm_up_wasm() {
+        assert!(crate::warm_up().await, "Warm up should succeed");
+        assert!(crate::warm_up().await, "Warm up should be repeatable");
+    }
+
     #[cfg(target_arch = "wasm32")]
     #[wasm_bindgen_test]
     async fn test_decode_mesh_with_config_wasm() {
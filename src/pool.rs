@@ -0,0 +1,325 @@
+//! Bounded worker pool behind the native async API.
+
+use std::collections::VecDeque;
+use std::fmt;
+use std::future::Future;
+use std::panic::{self, AssertUnwindSafe};
+use std::pin::Pin;
+use std::sync::atomic::{AtomicBool, Ordering};
+use std::sync::{Arc, Condvar, Mutex, OnceLock};
+use std::task::{Context, Poll, Waker};
+use std::thread::{self, JoinHandle};
+
+use crate::{DecodeOptions, MeshDecodeResult};
+
+/// Why a [`DecodeTask`] produced no result.
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum PoolError {
+    /// The queue of the pool was full when the task was submitted.
+    QueueFull,
+    /// The task was cancelled before it finished.
+    Cancelled,
+    /// Decoding failed.
+    DecodeFailed,
+}
+
+impl fmt::Display for PoolError {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        f.write_str(match self {
+            PoolError::QueueFull => "decode queue is full",
+            PoolError::Cancelled => "decode was cancelled",
+            PoolError::DecodeFailed => "decode failed",
+        })
+    }
+}
+
+impl std::error::Error for PoolError {}
+
+struct Job {
+    cancelled: Arc<AtomicBool>,
+    run: Box<dyn FnOnce() + Send>,
+}
+
+struct Queue {
+    jobs: VecDeque<Job>,
+    shutdown: bool,
+}
+
+struct Shared {
+    queue: Mutex<Queue>,
+    available: Condvar,
+}
+
+enum TaskState<T> {
+    Pending(Option<Waker>),
+    Done(Result<T, PoolError>),
+    Taken,
+}
+
+struct TaskSlot<T> {
+    state: Mutex<TaskState<T>>,
+}
+
+impl<T> TaskSlot<T> {
+    /// Stores the result of a pending task and wakes it. Does nothing if the
+    /// task already has a result.
+    fn complete(&self, result: Result<T, PoolError>) {
+        let mut state = self.state.lock().unwrap();
+        let TaskState::Pending(waker) = &mut *state else {
+            return;
+        };
+        let waker = waker.take();
+        *state = TaskState::Done(result);
+        drop(state);
+        if let Some(waker) = waker {
+            waker.wake();
+        }
+    }
+
+    fn is_pending(&self) -> bool {
+        matches!(*self.state.lock().unwrap(), TaskState::Pending(_))
+    }
+}
+
+/// A decode running on a [`DecodePool`].
+///
+/// Resolves to the result of the decode. Dropping the task, or calling
+/// [`DecodeTask::cancel`], removes it from the queue if it has not started; a
+/// decode that is already running finishes in the background and its result
+/// is discarded.
+#[must_use = "dropping a DecodeTask cancels it"]
+pub struct DecodeTask<T> {
+    slot: Arc<TaskSlot<T>>,
+    cancelled: Arc<AtomicBool>,
+    shared: Option<Arc<Shared>>,
+}
+
+impl<T> DecodeTask<T> {
+    fn finished(result: Result<T, PoolError>) -> Self {
+        Self {
+            slot: Arc::new(TaskSlot {
+                state: Mutex::new(TaskState::Done(result)),
+            }),
+            cancelled: Arc::new(AtomicBool::new(false)),
+            shared: None,
+        }
+    }
+
+    /// Cancels the task unless it has finished; it then resolves to
+    /// [`PoolError::Cancelled`].
+    pub fn cancel(&self) {
+        self.cancelled.store(true, Ordering::Release);
+        if let Some(shared) = &self.shared {
+            let mut queue = shared.queue.lock().unwrap();
+            queue
+                .jobs
+                .retain(|job| !Arc::ptr_eq(&job.cancelled, &self.cancelled));
+        }
+        self.slot.complete(Err(PoolError::Cancelled));
+    }
+}
+
+impl<T> Future for DecodeTask<T> {
+    type Output = Result<T, PoolError>;
+
+    fn poll(self: Pin<&mut Self>, cx: &mut Context<'_>) -> Poll<Self::Output> {
+        let mut state = self.slot.state.lock().unwrap();
+        match std::mem::replace(&mut *state, TaskState::Taken) {
+            TaskState::Done(result) => Poll::Ready(result),
+            TaskState::Pending(_) => {
+                *state = TaskState::Pending(Some(cx.waker().clone()));
+                Poll::Pending
+            }
+            TaskState::Taken => panic!("DecodeTask polled after completion"),
+        }
+    }
+}
+
+impl<T> Drop for DecodeTask<T> {
+    fn drop(&mut self) {
+        if self.slot.is_pending() {
+            self.cancel();
+        }
+    }
+}
+
+/// A fixed set of threads that run decodes off the async executor.
+///
+/// At most `num_threads` decodes run at once; further tasks wait in a queue,
+/// which can be bounded with [`DecodePool::with_queue_limit`]. The tasks are
+/// plain futures and work with any executor.
+///
+/// # Example
+///
+/// ```ignore
+/// use draco_decoder::DecodePool;
+///
+/// let pool = DecodePool::new(4).with_queue_limit(64);
+/// let result = pool.decode(data).await?;
+/// ```
+pub struct DecodePool {
+    shared: Arc<Shared>,
+    workers: Vec<JoinHandle<()>>,
+    queue_limit: usize,
+}
+
+impl DecodePool {
+    /// Starts a pool of `num_threads` decode threads with an unbounded queue.
+    /// `0` uses every available hardware thread.
+    pub fn new(num_threads: usize) -> Self {
+        let num_threads = match num_threads {
+            0 => thread::available_parallelism().map_or(1, |n| n.get()),
+            n => n,
+        };
+        let shared = Arc::new(Shared {
+            queue: Mutex::new(Queue {
+                jobs: VecDeque::new(),
+                shutdown: false,
+            }),
+            available: Condvar::new(),
+        });
+        let workers = (0..num_threads)
+            .map(|i| {
+                let shared = shared.clone();
+                thread::Builder::new()
+                    .name(format!("draco-decode-{i}"))
+                    .spawn(move || worker(&shared))
+                    .expect("Failed to spawn decode thread")
+            })
+            .collect();
+        Self {
+            shared,
+            workers,
+            queue_limit: usize::MAX,
+        }
+    }
+
+    /// Returns the pool behind the native async functions, started on first
+    /// use with one thread per hardware thread and an unbounded queue.
+    pub fn global() -> &'static DecodePool {
+        static POOL: OnceLock<DecodePool> = OnceLock::new();
+        POOL.get_or_init(|| DecodePool::new(0))
+    }
+
+    /// Limits the number of tasks waiting for a thread. Tasks submitted while
+    /// the queue is full resolve to [`PoolError::QueueFull`] right away.
+    pub fn with_queue_limit(mut self, queue_limit: usize) -> Self {
+        self.queue_limit = queue_limit;
+        self
+    }
+
+    /// Returns the number of decode threads.
+    pub fn num_threads(&self) -> usize {
+        self.workers.len()
+    }
+
+    /// Returns the number of tasks waiting for a thread.
+    pub fn queued(&self) -> usize {
+        self.shared.queue.lock().unwrap().jobs.len()
+    }
+
+    /// Decodes `data` like [`crate::decode_mesh_with_config_sync`].
+    pub fn decode<D>(&self, data: D) -> DecodeTask<MeshDecodeResult>
+    where
+        D: AsRef<[u8]> + Send + 'static,
+    {
+        self.spawn(move || crate::ffi::decode_mesh_with_config(data.as_ref()).ok())
+    }
+
+    /// Decodes `data` like [`crate::decode_mesh_with_options_sync`].
+    pub fn decode_with_options<D>(
+        &self,
+        data: D,
+        options: DecodeOptions,
+    ) -> DecodeTask<MeshDecodeResult>
+    where
+        D: AsRef<[u8]> + Send + 'static,
+    {
+        self.spawn(move || crate::ffi::decode_mesh_with_options(data.as_ref(), &options).ok())
+    }
+
+    /// Runs `job` on the pool. `None`, or a panic, resolves the task to
+    /// [`PoolError::DecodeFailed`].
+    pub fn spawn<T, F>(&self, job: F) -> DecodeTask<T>
+    where
+        T: Send + 'static,
+        F: FnOnce() -> Option<T> + Send + 'static,
+    {
+        let mut queue = self.shared.queue.lock().unwrap();
+        if queue.jobs.len() >= self.queue_limit {
+            return DecodeTask::finished(Err(PoolError::QueueFull));
+        }
+
+        let slot = Arc::new(TaskSlot {
+            state: Mutex::new(TaskState::Pending(None)),
+        });
+        let cancelled = Arc::new(AtomicBool::new(false));
+        let run = {
+            let slot = slot.clone();
+            let cancelled = cancelled.clone();
+            move || {
+                if cancelled.load(Ordering::Acquire) {
+                    slot.complete(Err(PoolError::Cancelled));
+                    return;
+                }
+                let result = panic::catch_unwind(AssertUnwindSafe(job))
+                    .ok()
+                    .flatten()
+                    .ok_or(PoolError::DecodeFailed);
+                slot.complete(result);
+            }
+        };
+        queue.jobs.push_back(Job {
+            cancelled: cancelled.clone(),
+            run: Box::new(run),
+        });
+        drop(queue);
+        self.shared.available.notify_one();
+
+        DecodeTask {
+            slot,
+            cancelled,
+            shared: Some(self.shared.clone()),
+        }
+    }
+
+    /// Cancels every task that has not started yet.
+    pub fn cancel_queued(&self) {
+        let jobs = std::mem::take(&mut self.shared.queue.lock().unwrap().jobs);
+        for job in jobs {
+            // A cancelled job only resolves its task.
+            job.cancelled.store(true, Ordering::Release);
+            (job.run)();
+        }
+    }
+}
+
+impl Drop for DecodePool {
+    /// Cancels the queued tasks and waits for the running ones.
+    fn drop(&mut self) {
+        self.cancel_queued();
+        self.shared.queue.lock().unwrap().shutdown = true;
+        self.shared.available.notify_all();
+        for worker in self.workers.drain(..) {
+            worker.join().ok();
+        }
+    }
+}
+
+fn worker(shared: &Shared) {
+    loop {
+        let job = {
+            let mut queue = shared.queue.lock().unwrap();
+            loop {
+                if let Some(job) = queue.jobs.pop_front() {
+                    break job;
+                }
+                if queue.shutdown {
+                    return;
+                }
+                queue = shared.available.wait(queue).unwrap();
+            }
+        };
+        (job.run)();
+    }
+}
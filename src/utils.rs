@@ -28,15 +28,91 @@ impl AttributeDataType {
     }
 }
 
+/// Semantic type of a mesh attribute, as stored in the Draco bitstream.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+pub enum AttributeType {
+    /// Vertex positions
+    Position,
+    /// Vertex normals
+    Normal,
+    /// Vertex colors
+    Color,
+    /// Texture coordinates
+    TexCoord,
+    /// Application specific data
+    Generic,
+    /// Type not reported by the decoder
+    Unknown,
+}
+
+/// Maximum number of components of an attribute that is kept quantized.
+pub const MAX_QUANTIZED_COMPONENTS: usize = 4;
+
+/// Dequantization parameters of an attribute kept in quantized form.
+///
+/// A quantized component `q` maps back to
+/// `origin[i] + q * range / (2^bits - 1)`. For `KHR_mesh_quantization` this is
+/// a uniform scale of `range / (2^bits - 1)` and a translation of `origin`.
+#[derive(Copy, Clone, Debug)]
+pub struct QuantizationInfo {
+    pub(crate) bits: u32,
+    pub(crate) range: f32,
+    pub(crate) origin: [f32; MAX_QUANTIZED_COMPONENTS],
+    pub(crate) dim: u32,
+}
+
+impl QuantizationInfo {
+    /// Returns the number of quantization bits per component.
+    pub fn bits(&self) -> u32 {
+        self.bits
+    }
+
+    /// Returns the extent of the quantized bounding box, the same on every axis.
+    pub fn range(&self) -> f32 {
+        self.range
+    }
+
+    /// Returns the minimum corner of the quantized bounding box, one value per
+    /// component.
+    pub fn origin(&self) -> &[f32] {
+        &self.origin[..self.dim as usize]
+    }
+
+    /// Returns the size of one quantization step, `range / (2^bits - 1)`.
+    pub fn step(&self) -> f32 {
+        self.range / ((1u64 << self.bits) - 1) as f32
+    }
+}
+
+// Parameters are compared bitwise so a config stays `Eq`.
+impl PartialEq for QuantizationInfo {
+    fn eq(&self, other: &Self) -> bool {
+        self.bits == other.bits
+            && self.range.to_bits() == other.range.to_bits()
+            && self.dim == other.dim
+            && self
+                .origin()
+                .iter()
+                .map(|v| v.to_bits())
+                .eq(other.origin().iter().map(|v| v.to_bits()))
+    }
+}
+
+impl Eq for QuantizationInfo {}
+
 /// Describes a single attribute in a decoded mesh.
 ///
 /// An attribute represents per-vertex data such as positions, normals, or texture coordinates.
 #[derive(Copy, Clone, Debug, PartialEq, Eq)]
 pub struct MeshAttribute {
-    dim: u32,
-    data_type: AttributeDataType,
-    offset: u32,
-    lenght: u32,
+    pub(crate) dim: u32,
+    pub(crate) data_type: AttributeDataType,
+    pub(crate) offset: u32,
+    pub(crate) lenght: u32,
+    pub(crate) byte_stride: u32,
+    pub(crate) attribute_type: AttributeType,
+    pub(crate) unique_id: u32,
+    pub(crate) quantization: Option<QuantizationInfo>,
 }
 
 impl MeshAttribute {
@@ -48,12 +124,19 @@ impl MeshAttribute {
     /// * `data_type` - The data type of each component
     /// * `offset` - Byte offset in the decoded buffer where this attribute starts
     /// * `lenght` - Total byte length of this attribute data
+    ///
+    /// The values are tightly packed, the attribute type is set to
+    /// [`AttributeType::Unknown`] and the unique id to 0.
     pub fn new(dim: u32, data_type: AttributeDataType, offset: u32, lenght: u32) -> Self {
         Self {
             dim,
             data_type,
             offset,
             lenght,
+            byte_stride: dim * data_type.size_in_bytes() as u32,
+            attribute_type: AttributeType::Unknown,
+            unique_id: 0,
+            quantization: None,
         }
     }
 
@@ -63,10 +146,21 @@ impl MeshAttribute {
     }
 
     /// Returns the total byte length of this attribute data.
+    ///
+    /// For interleaved layouts this is the span from the first value to the end
+    /// of the last one, including the other attributes in between.
     pub fn lenght(&self) -> u32 {
         self.lenght
     }
 
+    /// Returns the number of bytes between the values of consecutive vertices.
+    ///
+    /// Equals the value size for planar layouts and the vertex size for
+    /// interleaved ones.
+    pub fn byte_stride(&self) -> u32 {
+        self.byte_stride
+    }
+
     /// Returns the data type of this attribute.
     pub fn data_type(&self) -> AttributeDataType {
         self.data_type
@@ -76,39 +170,87 @@ impl MeshAttribute {
     pub fn dim(&self) -> u32 {
         self.dim
     }
+
+    /// Returns the semantic type of this attribute (position, normal, ...).
+    pub fn attribute_type(&self) -> AttributeType {
+        self.attribute_type
+    }
+
+    /// Returns the unique id of this attribute in the Draco bitstream.
+    ///
+    /// This is the id referenced by the `attributes` map of glTF's
+    /// `KHR_draco_mesh_compression` extension.
+    pub fn unique_id(&self) -> u32 {
+        self.unique_id
+    }
+
+    /// Returns the dequantization parameters if the values were kept quantized.
+    ///
+    /// See [`DecodeOptions::with_keep_quantized`].
+    pub fn quantization(&self) -> Option<&QuantizationInfo> {
+        self.quantization.as_ref()
+    }
 }
 
 /// Configuration and metadata for a decoded Draco mesh.
 ///
 /// This struct contains all the information needed to interpret the decoded
 /// mesh buffer, including vertex count, index count, and attribute layouts.
-#[derive(Debug, PartialEq, Eq)]
+#[derive(Clone, Debug, PartialEq, Eq)]
 pub struct DracoDecodeConfig {
     vertex_count: u32,
     index_count: u32,
+    index_data_type: AttributeDataType,
     index_length: u32,
     buffer_size: usize,
     attributes: Vec<MeshAttribute>,
 }
 
 impl DracoDecodeConfig {
-    /// Creates a new config with a pre-computed buffer size.
+    /// Creates a new config with a pre-computed buffer size and the index
+    /// width of [`IndexFormat::Auto`].
     ///
     /// Used internally when decoding from C++ FFI.
     pub(crate) fn new(vertex_count: u32, index_count: u32, buffer_size: usize) -> Self {
-        let index_length = if index_count <= u16::MAX as u32 {
-            index_count as usize * 2
+        let mut config = Self {
+            vertex_count: 0,
+            index_count: 0,
+            index_data_type: AttributeDataType::UInt16,
+            index_length: 0,
+            buffer_size: 0,
+            attributes: Vec::new(),
+        };
+        config.reset(vertex_count, index_count, buffer_size);
+        config
+    }
+
+    /// Resets the config for a new mesh, keeping the attribute storage.
+    ///
+    /// Used internally by reusable decoder contexts.
+    pub(crate) fn reset(&mut self, vertex_count: u32, index_count: u32, buffer_size: usize) {
+        self.vertex_count = vertex_count;
+        self.index_count = index_count;
+        self.buffer_size = buffer_size;
+        self.attributes.clear();
+        self.set_index_data_type(if vertex_count <= 1 << 16 {
+            AttributeDataType::UInt16
         } else {
-            index_count as usize * 4
-        } as u32;
+            AttributeDataType::UInt32
+        });
+    }
 
-        Self {
-            vertex_count,
-            index_count,
-            index_length,
-            buffer_size,
-            attributes: Vec::new(),
-        }
+    /// Sets the integer type of the indices.
+    ///
+    /// Used internally when the decoder picked another width.
+    pub(crate) fn set_index_data_type(&mut self, data_type: AttributeDataType) {
+        self.index_data_type = data_type;
+        self.index_length = self.index_count * data_type.size_in_bytes() as u32;
+    }
+
+    /// Returns the integer type of the indices: [`AttributeDataType::UInt8`],
+    /// [`AttributeDataType::UInt16`] or [`AttributeDataType::UInt32`].
+    pub fn index_data_type(&self) -> AttributeDataType {
+        self.index_data_type
     }
 
     /// Returns the total byte length of the index data.
@@ -116,22 +258,10 @@ impl DracoDecodeConfig {
         self.index_length
     }
 
-    /// Adds an attribute with specified offset and length.
+    /// Adds an attribute.
     ///
     /// Used internally when receiving attribute data from C++ FFI.
-    pub(crate) fn add_attribute(
-        &mut self,
-        dim: u32,
-        data_type: AttributeDataType,
-        offset: u32,
-        length: u32,
-    ) {
-        let attribute = MeshAttribute {
-            dim,
-            data_type,
-            offset,
-            lenght: length,
-        };
+    pub(crate) fn add_attribute(&mut self, attribute: MeshAttribute) {
         self.attributes.push(attribute);
     }
 
@@ -170,6 +300,291 @@ impl DracoDecodeConfig {
     }
 }
 
+/// Connectivity encoding of a Draco mesh.
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum EncoderMethod {
+    /// Faces stored as plain index lists.
+    Sequential,
+    /// Edgebreaker compressed connectivity.
+    Edgebreaker,
+}
+
+/// What [`crate::probe_mesh`] learns about a Draco mesh before decoding its
+/// attribute values.
+#[derive(Clone, Debug, PartialEq, Eq)]
+pub struct MeshProbe {
+    pub(crate) version: (u8, u8),
+    pub(crate) encoder_method: EncoderMethod,
+    pub(crate) has_metadata: bool,
+    pub(crate) config: DracoDecodeConfig,
+}
+
+impl MeshProbe {
+    /// Returns the Draco bitstream version as `(major, minor)`.
+    pub fn version(&self) -> (u8, u8) {
+        self.version
+    }
+
+    /// Returns the connectivity encoding.
+    pub fn encoder_method(&self) -> EncoderMethod {
+        self.encoder_method
+    }
+
+    /// Returns `true` if the mesh carries Draco metadata.
+    pub fn has_metadata(&self) -> bool {
+        self.has_metadata
+    }
+
+    /// Returns the config the decode will produce, with the vertex and index
+    /// counts, the index width (see [`DracoDecodeConfig::index_length`]), the
+    /// attributes and the buffer size.
+    ///
+    /// Under [`crate::DecodeOptions::with_keep_quantized`] this is an upper
+    /// bound: quantized attributes are reported as float, so their data types,
+    /// the offsets and the buffer size can be larger than after the decode.
+    pub fn config(&self) -> &DracoDecodeConfig {
+        &self.config
+    }
+}
+
+/// Arrangement of the vertex attributes in a decoded buffer.
+///
+/// The index block always comes first; this controls the blocks after it.
+#[derive(Clone, Debug, Default, PartialEq, Eq, Hash)]
+pub enum VertexLayout {
+    /// One tightly packed block per attribute, in unique id order.
+    #[default]
+    Planar,
+    /// Every attribute interleaved into a single vertex stream, in unique id
+    /// order.
+    Interleaved,
+    /// Attributes interleaved into caller-defined streams.
+    ///
+    /// Each inner list holds the unique ids of one stream, in vertex order.
+    /// Streams are written in list order; attributes that are not listed get a
+    /// planar block of their own after them, and unknown ids are ignored.
+    Grouped(Vec<Vec<u32>>),
+}
+
+/// Output format of 3D normals in a decoded buffer.
+///
+/// The packed formats hold signed normalized integers, so the GPU vertex
+/// format is the matching `snorm` one. Octahedral normals map the unit sphere
+/// onto `[-1, 1]^2`, with the lower hemisphere folded over the diagonals, and
+/// are unpacked in the shader.
+#[derive(Clone, Copy, Debug, Default, PartialEq, Eq, Hash)]
+pub enum NormalFormat {
+    /// Three `f32`s, as decoded by Draco.
+    #[default]
+    Float32,
+    /// Octahedral encoding in two `i16`s.
+    Oct16,
+    /// Octahedral encoding in two `i8`s.
+    Oct8,
+    /// Three `i16`s.
+    Snorm16,
+    /// Four `i8`s, the last one zero.
+    Snorm8,
+}
+
+/// Integer type of the indices in a decoded buffer.
+///
+/// The width is chosen from the vertex count, as the largest index is
+/// `vertex_count - 1`: u16 indices address up to 65,536 vertices whatever the
+/// number of faces.
+#[derive(Clone, Copy, Debug, Default, PartialEq, Eq, Hash)]
+pub enum IndexFormat {
+    /// u16 if every vertex fits, u32 otherwise. Every GPU API accepts both.
+    #[default]
+    Auto,
+    /// Like [`IndexFormat::Auto`], and u8 for meshes of up to 256 vertices.
+    /// glTF allows u8 indices, but WebGPU and many Vulkan and Metal drivers do
+    /// not.
+    Smallest,
+    /// Always u8; meshes with more than 256 vertices fail to decode.
+    U8,
+    /// Always u16; meshes with more than 65,536 vertices fail to decode.
+    U16,
+    /// Always u32.
+    U32,
+}
+
+/// Options controlling which attributes a decoded mesh buffer holds and how
+/// they are laid out.
+///
+/// # Example
+///
+/// ```
+/// use draco_decoder::{AttributeType, DecodeOptions, VertexLayout};
+///
+/// // Interleaved vertices with every attribute on a 4-byte boundary.
+/// let options = DecodeOptions::new()
+///     .with_layout(VertexLayout::Interleaved)
+///     .with_alignment(4);
+/// assert_eq!(options.alignment(), 4);
+///
+/// // Only positions and indices, e.g. for a collision mesh.
+/// let options = DecodeOptions::new().with_attribute_types(&[AttributeType::Position]);
+/// ```
+#[derive(Clone, Debug, Default, PartialEq, Eq, Hash)]
+pub struct DecodeOptions {
+    layout: VertexLayout,
+    alignment: u32,
+    attribute_alignments: Vec<(u32, u32)>,
+    attribute_types: Vec<AttributeType>,
+    attribute_ids: Vec<u32>,
+    keep_quantized: bool,
+    normal_format: NormalFormat,
+    index_format: IndexFormat,
+    optimize_vertex_cache: bool,
+}
+
+impl DecodeOptions {
+    /// Creates options for every attribute in the default planar, unaligned
+    /// layout.
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Sets the vertex layout.
+    pub fn with_layout(mut self, layout: VertexLayout) -> Self {
+        self.layout = layout;
+        self
+    }
+
+    /// Sets the alignment in bytes of every attribute inside a vertex.
+    ///
+    /// Attribute offsets and vertex strides are rounded up to this alignment and
+    /// the padding is zeroed. Must be a power of two; 0 and 1 mean unaligned.
+    pub fn with_alignment(mut self, alignment: u32) -> Self {
+        self.alignment = alignment;
+        self
+    }
+
+    /// Overrides the alignment of the attribute with `unique_id`.
+    ///
+    /// Must be a power of two; 0 falls back to [`DecodeOptions::with_alignment`].
+    pub fn with_attribute_alignment(mut self, unique_id: u32, alignment: u32) -> Self {
+        self.attribute_alignments.push((unique_id, alignment));
+        self
+    }
+
+    /// Decodes only attributes of the given types, plus any selected with
+    /// [`DecodeOptions::with_attribute_ids`].
+    ///
+    /// Other attributes are dropped right after the Draco decode and never
+    /// written; with a pure type filter, their dequantization is skipped too.
+    /// The indices are always decoded.
+    pub fn with_attribute_types(mut self, types: &[AttributeType]) -> Self {
+        self.attribute_types.extend_from_slice(types);
+        self
+    }
+
+    /// Decodes only attributes with the given unique ids, plus any selected by
+    /// [`DecodeOptions::with_attribute_types`].
+    ///
+    /// This only shrinks the output: Draco still decodes and dequantizes every
+    /// attribute, and the unselected ones are dropped afterwards. Only a
+    /// filter made of types alone saves decode time.
+    pub fn with_attribute_ids(mut self, unique_ids: &[u32]) -> Self {
+        self.attribute_ids.extend_from_slice(unique_ids);
+        self
+    }
+
+    /// Keeps quantized attributes as the raw quantized integers instead of
+    /// dequantizing them to float.
+    ///
+    /// Applies to positions, texture coordinates, colors and generic
+    /// attributes that were quantized at encode time. Their values are written
+    /// as the smallest unsigned type that fits the quantization bits, and
+    /// [`MeshAttribute::quantization`] reports the parameters needed to
+    /// dequantize them, e.g. on the GPU with `KHR_mesh_quantization`.
+    pub fn with_keep_quantized(mut self, keep_quantized: bool) -> Self {
+        self.keep_quantized = keep_quantized;
+        self
+    }
+
+    /// Sets the output format of 3D normals.
+    ///
+    /// The config reports the packed normals with the dimension and data type
+    /// of the format, e.g. 2 and [`AttributeDataType::Int16`] for
+    /// [`NormalFormat::Oct16`].
+    pub fn with_normal_format(mut self, normal_format: NormalFormat) -> Self {
+        self.normal_format = normal_format;
+        self
+    }
+
+    /// Sets the integer type of the indices.
+    ///
+    /// A forced width that cannot address every vertex makes the options
+    /// invalid for that mesh. [`DracoDecodeConfig::index_data_type`] reports
+    /// the chosen type.
+    pub fn with_index_format(mut self, index_format: IndexFormat) -> Self {
+        self.index_format = index_format;
+        self
+    }
+
+    /// Reorders the triangles for GPU post-transform vertex cache reuse and
+    /// renumbers the vertices in order of first use, for fetch locality.
+    ///
+    /// Runs once, right after the Draco decode, in time linear in the index
+    /// count; the vertex values are then written in the new order by the one
+    /// pass that writes the buffer. The layout and size of the buffer do not
+    /// change. It replaces a separate optimization pass over the decoded mesh,
+    /// such as meshoptimizer's `optimizeVertexCache` and `optimizeVertexFetch`.
+    pub fn with_vertex_cache_optimization(mut self, optimize: bool) -> Self {
+        self.optimize_vertex_cache = optimize;
+        self
+    }
+
+    /// Returns the vertex layout.
+    pub fn layout(&self) -> &VertexLayout {
+        &self.layout
+    }
+
+    /// Returns the default attribute alignment.
+    pub fn alignment(&self) -> u32 {
+        self.alignment
+    }
+
+    /// Returns the per-attribute alignment overrides as `(unique_id, alignment)`.
+    pub fn attribute_alignments(&self) -> &[(u32, u32)] {
+        &self.attribute_alignments
+    }
+
+    /// Returns the attribute types selected for decoding. Empty together with
+    /// [`DecodeOptions::attribute_ids`] means every attribute.
+    pub fn attribute_types(&self) -> &[AttributeType] {
+        &self.attribute_types
+    }
+
+    /// Returns the attribute unique ids selected for decoding.
+    pub fn attribute_ids(&self) -> &[u32] {
+        &self.attribute_ids
+    }
+
+    /// Returns `true` if quantized attributes are kept quantized.
+    pub fn keep_quantized(&self) -> bool {
+        self.keep_quantized
+    }
+
+    /// Returns the output format of 3D normals.
+    pub fn normal_format(&self) -> NormalFormat {
+        self.normal_format
+    }
+
+    /// Returns the integer type of the indices.
+    pub fn index_format(&self) -> IndexFormat {
+        self.index_format
+    }
+
+    /// Returns `true` if triangles and vertices are reordered for the vertex
+    /// cache.
+    pub fn optimize_vertex_cache(&self) -> bool {
+        self.optimize_vertex_cache
+    }
+}
+
 /// Typed values for a decoded mesh attribute.
 #[derive(Debug)]
 pub enum AttributeValues {
@@ -199,3 +614,36 @@ pub struct MeshDecodeResult {
     /// Metadata describing the mesh structure and attribute layouts.
     pub config: DracoDecodeConfig,
 }
+
+/// Result of decoding several Draco meshes into one shared buffer.
+///
+/// Meshes are stored back to back in `data`, each starting at a 4-byte aligned
+/// offset. Offsets inside each config are relative to the start of that mesh.
+#[derive(Debug)]
+pub struct BatchDecodeResult {
+    /// The shared buffer containing every decoded mesh.
+    pub data: Vec<u8>,
+    /// Metadata describing each mesh, in input order.
+    pub configs: Vec<DracoDecodeConfig>,
+    /// Byte offset of each mesh in `data`, in input order.
+    pub offsets: Vec<usize>,
+}
+
+impl BatchDecodeResult {
+    /// Returns the number of meshes in the batch.
+    pub fn len(&self) -> usize {
+        self.configs.len()
+    }
+
+    /// Returns `true` if the batch contains no meshes.
+    pub fn is_empty(&self) -> bool {
+        self.configs.is_empty()
+    }
+
+    /// Returns the decoded buffer of the mesh at the given index, if it exists.
+    pub fn mesh_data(&self, index: usize) -> Option<&[u8]> {
+        let offset = *self.offsets.get(index)?;
+        let size = self.configs[index].buffer_size();
+        self.data.get(offset..offset + size)
+    }
+}
@@ -4,37 +4,46 @@ use wasm_bindgen::JsCast;
 use wasm_bindgen::prelude::*;
 use wasm_bindgen_futures::JsFuture;
 
-use crate::{AttributeDataType, DracoDecodeConfig};
+use crate::{AttributeDataType, AttributeType, DracoDecodeConfig, MeshAttribute};
 
 thread_local! {
     static DRACO_DECODE_FUNC_MODULE: RefCell<Option<JsValue>> = RefCell::new(None);
 }
 
+/// Generated bundle of draco_decoder_js, whose worker script the pool runs
+const BUNDLE: &str = include_str!("../javascript/index.es.js");
+/// Worker pool over the bundle, see `javascript/pool.es.js`
+const POOL: &str = include_str!("../javascript/pool.es.js");
+/// The Draco module embedded in the bundle, compiled once by the pool
+const DRACO_WASM: &[u8] = include_bytes!("../javascript/draco3d/draco_decoder.wasm");
+
 async fn get_js_module() -> Result<JsValue, JsValue> {
     if let Some(module) = DRACO_DECODE_FUNC_MODULE.with(|m| m.borrow().clone()) {
         return Ok(module);
     }
 
-    let js_code = include_str!("../javascript/index.es.js");
-    let escaped = js_code.replace("\\", "\\\\").replace("`", "\\`");
-
-    let setup_code = format!(
+    let import_source: js_sys::Function = js_sys::eval(
         r#"
-        (function() {{
-            const code = `{escaped}`;
-            const blob = new Blob([code], {{ type: "application/javascript" }});
+        (code) => {
+            const blob = new Blob([code], { type: "application/javascript" });
             const url = URL.createObjectURL(blob);
-            return import(url).then(mod => {{
-                URL.revokeObjectURL(url);
-                return mod;
-            }});
-        }})()
-    "#
-    );
-
-    let js_module = js_sys::eval(&setup_code)?;
-    let module_promise: Promise = js_module.dyn_into()?;
-    let module = JsFuture::from(module_promise).await?;
+            return import(url).finally(() => URL.revokeObjectURL(url));
+        }
+    "#,
+    )?
+    .dyn_into()?;
+    let import: Promise = import_source
+        .call1(&JsValue::NULL, &JsValue::from_str(POOL))?
+        .dyn_into()?;
+    let pool_module = JsFuture::from(import).await?;
+
+    let create_pool = js_sys::Reflect::get(&pool_module, &JsValue::from_str("createPool"))?
+        .dyn_into::<js_sys::Function>()?;
+    let module = create_pool.call2(
+        &JsValue::NULL,
+        &JsValue::from_str(BUNDLE),
+        &Uint8Array::from(DRACO_WASM),
+    )?;
 
     DRACO_DECODE_FUNC_MODULE.with(|m| m.replace(Some(module.clone())));
 
@@ -73,11 +82,20 @@ async fn decode_draco_mesh_from_embedded_js_with_config(
     let buffer_size = js_sys::Reflect::get(&config_obj, &JsValue::from_str("buffer_size"))?
         .as_f64()
         .unwrap_or(0.0) as usize;
+    let index_length = js_sys::Reflect::get(&config_obj, &JsValue::from_str("index_length"))?
+        .as_f64()
+        .unwrap_or(0.0) as u32;
 
     let attributes_array =
         js_sys::Reflect::get(&config_obj, &JsValue::from_str("attributes"))?.dyn_into::<Array>()?;
 
     let mut config = DracoDecodeConfig::new(vertex_count, index_count, buffer_size);
+    // The worker picks its own index width, so follow the bytes it wrote.
+    if index_count > 0 && index_length == index_count * 4 {
+        config.set_index_data_type(AttributeDataType::UInt32);
+    } else if index_count > 0 && index_length == index_count * 2 {
+        config.set_index_data_type(AttributeDataType::UInt16);
+    }
 
     for i in 0..attributes_array.length() {
         let attr_obj = attributes_array.get(i).dyn_into::<Object>()?;
@@ -106,12 +124,49 @@ async fn decode_draco_mesh_from_embedded_js_with_config(
             _ => AttributeDataType::Float32,
         };
 
-        config.add_attribute(dim, attr_data_type, offset, length);
+        // The worker emits attributes by unique id but does not report their type.
+        config.add_attribute(MeshAttribute {
+            dim,
+            data_type: attr_data_type,
+            offset,
+            lenght: length,
+            byte_stride: dim * attr_data_type.size_in_bytes() as u32,
+            attribute_type: AttributeType::Unknown,
+            unique_id: i,
+            quantization: None,
+        });
     }
 
     Ok((decoded_array.to_vec(), config))
 }
 
+async fn warm_up_worker() -> Result<(), JsValue> {
+    let module = get_js_module().await?;
+    let warm_up_fn = js_sys::Reflect::get(&module, &JsValue::from_str("warmUp"))?
+        .dyn_into::<js_sys::Function>()?;
+    let promise: Promise = warm_up_fn.call0(&JsValue::NULL)?.dyn_into()?;
+    JsFuture::from(promise).await?;
+    Ok(())
+}
+
+/// Loads the embedded scripts, compiles the Draco wasm module once with
+/// `WebAssembly.compileStreaming` and instantiates it in the first worker.
+/// Later workers are instantiated from the same compiled module.
+pub async fn warm_up() -> bool {
+    match warm_up_worker().await {
+        Ok(()) => true,
+        Err(err) => {
+            web_sys::console::error_1(&err);
+            false
+        }
+    }
+}
+
+/// Decodes `data` on the worker pool of `javascript/pool.es.js`, which
+/// dispatches to the least busy worker and adds one, up to
+/// `navigator.hardwareConcurrency`, while every worker is busy. The input is
+/// copied out of wasm memory once and then transferred to the worker, like the
+/// decoded buffer on the way back.
 pub async fn decode_mesh_wasm_worker_with_config(data: &[u8]) -> Option<crate::MeshDecodeResult> {
     let js_array = Uint8Array::from(data);
 
@@ -23,12 +23,29 @@ console.log('Copying index.es.js...');
 fs.copyFileSync(srcJsFile, destJsFile);
 console.log('Copied index.es.js to javascript/');
 
+// javascript/pool.es.js takes the worker script that the bundle passes to
+// `new Worker` on import and speaks its message protocol, so fail here
+// rather than in the browser if either is gone.
+const bundle = fs.readFileSync(destJsFile, 'utf8');
+for (const marker of ['new Worker(', 'withConfig', 'bufferLength']) {
+  if (!bundle.includes(marker)) {
+    throw new Error(`index.es.js no longer contains ${marker}`);
+  }
+}
+
 // Copy draco_decoder.wasm
 console.log('Copying draco_decoder.wasm...');
 fs.mkdirSync(destWasmDir, { recursive: true });
 fs.copyFileSync(srcWasmFile, destWasmFile);
 console.log('Copied draco_decoder.wasm to javascript/draco3d/');
 
+// javascript/pool.es.js compiles this file and hands the module to the glue in
+// the bundle's worker, so it must be the module that glue was built against.
+const embedded = bundle.match(/data:application\/wasm;base64,([A-Za-z0-9+/=]+)/);
+if (!embedded || !Buffer.from(embedded[1], 'base64').equals(fs.readFileSync(destWasmFile))) {
+  throw new Error('draco_decoder.wasm differs from the module embedded in index.es.js');
+}
+
 // Build Rust
 console.log('Building Rust...');
 execSync('cargo build', { cwd: rootDir, stdio: 'inherit' });